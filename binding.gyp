@@ -12,6 +12,9 @@
         "src/crnn_net.cpp",
         "src/ocr_engine.cpp",
         "src/utils.cpp",
+        "src/model_pool.cpp",
+        "src/thread_pool.cpp",
+        "src/components.cpp",
         "src/3rdparty/clipper2/clipper.engine.cpp",
         "src/3rdparty/clipper2/clipper.offset.cpp",
         "src/3rdparty/clipper2/clipper.rectclip.cpp"
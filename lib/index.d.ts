@@ -32,6 +32,127 @@ export interface OCRResult {
     angle: AngleInfo;
 }
 
+/**
+ * A detected text box without recognition, returned by detectBoxes()
+ */
+export interface TextBox {
+    /** Bounding box points (4 corners of the text region) */
+    box: Point[];
+    /** Confidence score of the text detection */
+    boxScore: number;
+}
+
+/**
+ * A line yielded by detectStream()
+ */
+export interface StreamedOCRResult extends OCRResult {
+    /** Position of the line in the complete results of the image */
+    index: number;
+}
+
+/**
+ * Columnar encoding of the results of one image, returned with { compact: true }.
+ * Line i owns boxes[8i .. 8i + 7] (x0, y0, ..., x3, y3),
+ * charScores[charOffsets[i] .. charOffsets[i + 1]) and the UTF-8 bytes
+ * text[textOffsets[i] .. textOffsets[i + 1]).
+ */
+export interface CompactResults {
+    /** Number of text lines */
+    count: number;
+    /** Corner points, 8 values per line */
+    boxes: Int32Array;
+    /** Detection confidence per line */
+    boxScores: Float32Array;
+    /** Angle classification confidence per line */
+    angleScores: Float32Array;
+    /** 1 if the line is rotated 180 degrees */
+    rotated: Uint8Array;
+    /** Character confidences of all lines */
+    charScores: Float32Array;
+    /** count + 1 offsets into charScores */
+    charOffsets: Uint32Array;
+    /** UTF-8 text of all lines */
+    text: Buffer;
+    /** count + 1 byte offsets into text */
+    textOffsets: Uint32Array;
+    /** Set when the run was stopped by timeout or signal */
+    partial?: true;
+}
+
+/**
+ * Options accepted by every detect method
+ */
+export interface DetectOptions {
+    /** Return CompactResults instead of OCRResult objects */
+    compact?: boolean;
+    /** Skip detection, the whole image is one text line that goes straight to classification and recognition */
+    lineMode?: boolean;
+    /**
+     * Stop after this many milliseconds, counted from the call. The lines
+     * recognized until then are returned with `partial: true`.
+     */
+    timeout?: number;
+    /** Stop the run when aborted (async methods only), same result as timeout */
+    signal?: AbortSignal;
+}
+
+/**
+ * Result type of a detection with the given options
+ */
+export type DetectResult<O extends DetectOptions | undefined> =
+    O extends { compact: true } ? CompactResults : OCRResults;
+
+/**
+ * Results of one image
+ */
+export type OCRResults = OCRResult[] & {
+    /** Set when the run was stopped by timeout or signal, only recognized lines are included */
+    partial?: true;
+};
+
+/**
+ * Layout of raw pixel input
+ */
+export interface PixelOptions extends DetectOptions {
+    /** Image width in pixels */
+    width: number;
+    /** Image height in pixels */
+    height: number;
+    /** Bytes per row, defaults to width * channels */
+    stride?: number;
+    /** Channel order, defaults to 'bgr' */
+    format?: 'bgr' | 'rgb' | 'bgra' | 'gray';
+}
+
+/**
+ * Raw pixel data, read in place by the native addon
+ */
+export type PixelData = Buffer | NodeJS.TypedArray | ArrayBuffer | SharedArrayBuffer;
+
+/**
+ * Depth of a queue between two pipeline stages, sampled whenever an image is queued
+ */
+export interface QueueStats {
+    /** Configured queue_size */
+    capacity: number;
+    maxDepth: number;
+    meanDepth: number;
+    /** Times the previous stage had to wait because the queue was full */
+    fullWaits: number;
+}
+
+/**
+ * Queue depths summed over all pipelined runs of an engine
+ */
+export interface PipelineStats {
+    runs: number;
+    images: number;
+    /** Detected images waiting for classification */
+    clsQueue: QueueStats;
+    /** Classified images waiting for recognition */
+    recQueue: QueueStats;
+}
+
 /**
  * PaddleOCR engine class
  */
@@ -51,16 +172,109 @@ export class PaddleOCR {
     /**
      * Detect and recognize text in an image file
      * @param imagePath - Path to the image file
+     * @param options - Detection options
      * @returns Array of detected text regions with recognition results
      */
-    detect(imagePath: string): OCRResult[];
+    detect<O extends DetectOptions | undefined = undefined>(imagePath: string, options?: O): DetectResult<O>;
 
     /**
      * Detect and recognize text in an image buffer
      * @param buffer - Image data as a Buffer
+     * @param options - Detection options
      * @returns Array of detected text regions with recognition results
      */
-    detectBuffer(buffer: Buffer): OCRResult[];
+    detectBuffer<O extends DetectOptions | undefined = undefined>(buffer: Buffer, options?: O): DetectResult<O>;
+
+    /**
+     * Detect and recognize text in decoded pixels without copying them
+     * @param data - Pixel data
+     * @param options - Pixel layout and detection options
+     * @returns Array of detected text regions with recognition results
+     */
+    detectPixels<O extends PixelOptions>(data: PixelData, options: O): DetectResult<O>;
+
+    /**
+     * Detect and recognize text in several images, recognizing the lines of all images together
+     * @param inputs - Image file paths or encoded image Buffers
+     * @param options - Detection options
+     * @returns Results of each input, in input order
+     */
+    detectMany<O extends DetectOptions | undefined = undefined>(inputs: Array<string | Buffer>, options?: O): Array<DetectResult<O>>;
+
+    /**
+     * Detect and recognize text in an image file on a worker thread
+     * @param imagePath - Path to the image file
+     * @param options - Detection options
+     * @returns Promise of detected text regions with recognition results
+     */
+    detectAsync<O extends DetectOptions | undefined = undefined>(imagePath: string, options?: O): Promise<DetectResult<O>>;
+
+    /**
+     * Detect and recognize text in an image buffer on a worker thread
+     * @param buffer - Image data as a Buffer, copied before the call returns
+     * @param options - Detection options
+     * @returns Promise of detected text regions with recognition results
+     */
+    detectBufferAsync<O extends DetectOptions | undefined = undefined>(buffer: Buffer, options?: O): Promise<DetectResult<O>>;
+
+    /**
+     * Detect and recognize text in decoded pixels on a worker thread
+     * @param data - Pixel data, copied unless in a SharedArrayBuffer, whose pixels must not change until the promise settles
+     * @param options - Pixel layout and detection options
+     * @returns Promise of detected text regions with recognition results
+     */
+    detectPixelsAsync<O extends PixelOptions>(data: PixelData, options: O): Promise<DetectResult<O>>;
+
+    /**
+     * Detect and recognize text in several images on a worker thread
+     * @param inputs - Image file paths or encoded image Buffers, copied before the call returns
+     * @param options - Detection options
+     * @returns Promise of the results of each input, in input order
+     */
+    detectManyAsync<O extends DetectOptions | undefined = undefined>(inputs: Array<string | Buffer>, options?: O): Promise<Array<DetectResult<O>>>;
+
+    /**
+     * Detect text boxes only, skipping classification and recognition
+     * @param input - Image file path or encoded image Buffer
+     * @param options - compact/timeout as for detect()
+     */
+    detectBoxes(input: string | Buffer, options?: DetectOptions): TextBox[];
+
+    /**
+     * Detect text boxes only on a worker thread
+     * @param input - Image file path or encoded image Buffer, copied before the call returns
+     * @param options - compact/signal/timeout as for detectAsync()
+     */
+    detectBoxesAsync(input: string | Buffer, options?: DetectOptions): Promise<TextBox[]>;
+
+    /**
+     * Recognize already cropped text lines, skipping detection
+     * @param crops - One text line per image file path or encoded image Buffer
+     * @param options - Detection options
+     * @returns One result per crop, the box covers the whole crop
+     */
+    recognize<O extends DetectOptions | undefined = undefined>(crops: Array<string | Buffer>, options?: O): DetectResult<O>;
+
+    /**
+     * Recognize already cropped text lines on a worker thread
+     * @param crops - One text line per image file path or encoded image Buffer, copied before the call returns
+     * @param options - Detection options
+     * @returns Promise of one result per crop
+     */
+    recognizeAsync<O extends DetectOptions | undefined = undefined>(crops: Array<string | Buffer>, options?: O): Promise<DetectResult<O>>;
+
+    /**
+     * Detect text and yield each line as soon as it is recognized.
+     * Lines arrive out of order, `index` is their position in the complete results.
+     * @param input - Image file path or encoded image Buffer, copied before the call returns
+     * @param options - signal/timeout end the stream early
+     */
+    detectStream(input: string | Buffer, options?: DetectOptions): AsyncGenerator<StreamedOCRResult, void, undefined>;
+
+    /**
+     * Get the queue depths of the pipelined runs of this engine
+     */
+    pipelineStats(): PipelineStats;
 
     /**
      * Check if the engine is initialized
@@ -75,13 +289,66 @@ export class PaddleOCR {
  */
 export function createOCR(configPath?: string): PaddleOCR;
 
+/**
+ * Expand compact results into regular OCRResult objects
+ * @param compact - Results returned with { compact: true }
+ */
+export function expandCompactResults(compact: CompactResults): OCRResult[];
+
+/**
+ * Limit how many detections run at the same time across all engines of the
+ * process, including engines in other worker_threads
+ * @param maxConcurrency - Maximum number of concurrent runs, 0 for unlimited
+ */
+export function setMaxConcurrency(maxConcurrency: number): void;
+
+/**
+ * Get the process-wide limit of concurrent detections (0 for unlimited)
+ */
+export function getMaxConcurrency(): number;
+
+/**
+ * Native cancellation handle, see NativeDetectOptions
+ */
+export interface NativeCancelToken {
+    cancel(): void;
+}
+
+/**
+ * Options of the raw native methods, AbortSignal is mapped to cancelToken by PaddleOCR
+ */
+export interface NativeDetectOptions {
+    compact?: boolean;
+    lineMode?: boolean;
+    timeout?: number;
+    cancelToken?: NativeCancelToken;
+}
+
 /**
  * Raw native binding (for advanced usage)
  */
 export const _binding: {
+    CancelToken: new () => NativeCancelToken;
+    setMaxConcurrency(maxConcurrency: number): void;
+    getMaxConcurrency(): number;
     OCREngine: new () => {
         initialize(configPath: string): boolean;
-        detect(imagePath: string): OCRResult[];
-        detectBuffer(buffer: Buffer): OCRResult[];
+        detect(imagePath: string, options?: NativeDetectOptions): OCRResult[] | CompactResults;
+        detectBuffer(buffer: Buffer, options?: NativeDetectOptions): OCRResult[] | CompactResults;
+        detectAsync(imagePath: string, options?: NativeDetectOptions): Promise<OCRResult[] | CompactResults>;
+        detectBufferAsync(buffer: Buffer, options?: NativeDetectOptions): Promise<OCRResult[] | CompactResults>;
+        detectPixels(data: NodeJS.TypedArray, width: number, height: number, stride: number, format: string,
+            options?: NativeDetectOptions): OCRResult[] | CompactResults;
+        detectPixelsAsync(data: NodeJS.TypedArray, width: number, height: number, stride: number, format: string,
+            options?: NativeDetectOptions): Promise<OCRResult[] | CompactResults>;
+        detectMany(inputs: Array<string | Buffer>, options?: NativeDetectOptions): Array<OCRResult[] | CompactResults>;
+        detectManyAsync(inputs: Array<string | Buffer>, options?: NativeDetectOptions): Promise<Array<OCRResult[] | CompactResults>>;
+        detectStream(input: string | Buffer, onResult: (result: StreamedOCRResult) => void,
+            options?: NativeDetectOptions): Promise<OCRResults>;
+        detectBoxes(input: string | Buffer, options?: NativeDetectOptions): TextBox[] | CompactResults;
+        detectBoxesAsync(input: string | Buffer, options?: NativeDetectOptions): Promise<TextBox[] | CompactResults>;
+        recognize(crops: Array<string | Buffer>, options?: NativeDetectOptions): OCRResult[] | CompactResults;
+        recognizeAsync(crops: Array<string | Buffer>, options?: NativeDetectOptions): Promise<OCRResult[] | CompactResults>;
+        pipelineStats(): PipelineStats;
     };
 };
@@ -90,6 +90,77 @@ function loadBinding() {
 
 const binding = loadBinding();
 
+const PIXEL_CHANNELS = { bgr: 3, rgb: 3, bgra: 4, gray: 1 };
+
+/**
+ * Normalize raw pixel input to the (data, width, height, stride, format)
+ * arguments of the native binding without copying the pixels
+ */
+function pixelArgs(data, options) {
+    if (data instanceof ArrayBuffer ||
+        (typeof SharedArrayBuffer !== 'undefined' && data instanceof SharedArrayBuffer)) {
+        data = new Uint8Array(data);
+    } else if (!ArrayBuffer.isView(data) || data instanceof DataView) {
+        throw new Error('Expected a Buffer, TypedArray, ArrayBuffer or SharedArrayBuffer');
+    }
+    const { width, height } = options || {};
+    const format = (options && options.format) || 'bgr';
+    const channels = PIXEL_CHANNELS[format];
+    if (!channels) {
+        throw new Error(`Unknown pixel format: ${format}`);
+    }
+    if (!Number.isInteger(width) || !Number.isInteger(height)) {
+        throw new Error('Expected integer width and height');
+    }
+    const stride = (options && options.stride) || width * channels;
+    return [data, width, height, stride, format];
+}
+
+/**
+ * Resolve image paths of a detectMany() input list, buffers are passed through
+ */
+function batchArgs(inputs) {
+    if (!Array.isArray(inputs)) {
+        throw new Error('Expected an array of image paths or Buffers');
+    }
+    return inputs.map((input) => {
+        if (Buffer.isBuffer(input)) {
+            return input;
+        }
+        if (typeof input !== 'string') {
+            throw new Error('Expected an image path or a Buffer');
+        }
+        const absolutePath = path.resolve(input);
+        if (!fs.existsSync(absolutePath)) {
+            throw new Error(`Image file not found: ${absolutePath}`);
+        }
+        return absolutePath;
+    });
+}
+
+/**
+ * Run an async native call with options.signal mapped to a native CancelToken.
+ * An aborted run resolves with the lines recognized so far and `partial: true`.
+ */
+async function withSignal(options, run) {
+    const signal = options && options.signal;
+    if (!signal) {
+        return run(options);
+    }
+    const cancelToken = new binding.CancelToken();
+    const onAbort = () => cancelToken.cancel();
+    if (signal.aborted) {
+        cancelToken.cancel();
+    } else {
+        signal.addEventListener('abort', onAbort, { once: true });
+    }
+    try {
+        return await run({ ...options, cancelToken });
+    } finally {
+        signal.removeEventListener('abort', onAbort);
+    }
+}
+
 /**
  * OCR Engine class for text detection and recognition
  */
@@ -119,9 +190,10 @@ class PaddleOCR {
     /**
      * Detect and recognize text in an image file
      * @param {string} imagePath - Path to the image file
+     * @param {DetectOptions} [options] - { compact: true } returns CompactResults instead, timeout (ms) stops early
      * @returns {Array<OCRResult>} - Array of detected text regions with recognition results
      */
-    detect(imagePath) {
+    detect(imagePath, options) {
         if (!this._initialized) {
             throw new Error('OCR engine not initialized. Call init() first.');
         }
@@ -129,22 +201,248 @@ class PaddleOCR {
         if (!fs.existsSync(absolutePath)) {
             throw new Error(`Image file not found: ${absolutePath}`);
         }
-        return this._engine.detect(absolutePath);
+        return this._engine.detect(absolutePath, options);
     }
 
     /**
      * Detect and recognize text in an image buffer
      * @param {Buffer} buffer - Image data as a Buffer
+     * @param {DetectOptions} [options] - { compact: true } returns CompactResults instead, timeout (ms) stops early
      * @returns {Array<OCRResult>} - Array of detected text regions with recognition results
      */
-    detectBuffer(buffer) {
+    detectBuffer(buffer, options) {
         if (!this._initialized) {
             throw new Error('OCR engine not initialized. Call init() first.');
         }
         if (!Buffer.isBuffer(buffer)) {
             throw new Error('Expected a Buffer');
         }
-        return this._engine.detectBuffer(buffer);
+        return this._engine.detectBuffer(buffer, options);
+    }
+
+    /**
+     * Detect and recognize text in decoded pixels, read in place without copying
+     * @param {Buffer|TypedArray|ArrayBuffer|SharedArrayBuffer} data - Pixel data
+     * @param {PixelOptions} options - width, height, optional stride in bytes and format ('bgr', 'rgb', 'bgra' or 'gray'), plus DetectOptions
+     * @returns {Array<OCRResult>} - Array of detected text regions with recognition results
+     */
+    detectPixels(data, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        return this._engine.detectPixels(...pixelArgs(data, options), options);
+    }
+
+    /**
+     * Detect and recognize text in several images, recognizing the lines of all images together
+     * @param {Array<string|Buffer>} inputs - Image file paths or encoded image Buffers
+     * @param {DetectOptions} [options] - { compact: true } returns CompactResults per input instead, timeout (ms) stops early
+     * @returns {Array<Array<OCRResult>>} - Results of each input, in input order
+     */
+    detectMany(inputs, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        return this._engine.detectMany(batchArgs(inputs), options);
+    }
+
+    /**
+     * Detect and recognize text in an image file without blocking the event loop
+     * @param {string} imagePath - Path to the image file
+     * @param {DetectOptions} [options] - { compact: true } resolves with CompactResults instead, signal/timeout stop early
+     * @returns {Promise<Array<OCRResult>>} - Resolves with the detected text regions
+     */
+    async detectAsync(imagePath, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        const absolutePath = path.resolve(imagePath);
+        if (!fs.existsSync(absolutePath)) {
+            throw new Error(`Image file not found: ${absolutePath}`);
+        }
+        return withSignal(options, (opts) => this._engine.detectAsync(absolutePath, opts));
+    }
+
+    /**
+     * Detect and recognize text in an image buffer without blocking the event loop
+     * @param {Buffer} buffer - Image data as a Buffer, copied before the call returns
+     * @param {DetectOptions} [options] - { compact: true } resolves with CompactResults instead, signal/timeout stop early
+     * @returns {Promise<Array<OCRResult>>} - Resolves with the detected text regions
+     */
+    async detectBufferAsync(buffer, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        if (!Buffer.isBuffer(buffer)) {
+            throw new Error('Expected a Buffer');
+        }
+        return withSignal(options, (opts) => this._engine.detectBufferAsync(buffer, opts));
+    }
+
+    /**
+     * Detect and recognize text in decoded pixels without blocking the event loop
+     * @param {Buffer|TypedArray|ArrayBuffer|SharedArrayBuffer} data - Pixel data, copied unless in a SharedArrayBuffer, whose pixels must not change until the promise settles
+     * @param {PixelOptions} options - width, height, optional stride in bytes and format ('bgr', 'rgb', 'bgra' or 'gray'), plus DetectOptions
+     * @returns {Promise<Array<OCRResult>>} - Resolves with the detected text regions
+     */
+    async detectPixelsAsync(data, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        const args = pixelArgs(data, options);
+        return withSignal(options, (opts) => this._engine.detectPixelsAsync(...args, opts));
+    }
+
+    /**
+     * Detect and recognize text in several images without blocking the event loop
+     * @param {Array<string|Buffer>} inputs - Image file paths or encoded image Buffers, copied before the call returns
+     * @param {DetectOptions} [options] - { compact: true } resolves with CompactResults per input instead, signal/timeout stop early
+     * @returns {Promise<Array<Array<OCRResult>>>} - Resolves with the results of each input, in input order
+     */
+    async detectManyAsync(inputs, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        const sources = batchArgs(inputs);
+        return withSignal(options, (opts) => this._engine.detectManyAsync(sources, opts));
+    }
+
+    /**
+     * Detect text boxes only, skipping classification and recognition
+     * @param {string|Buffer} input - Image file path or encoded image Buffer
+     * @param {DetectOptions} [options] - compact/timeout as for detect()
+     * @returns {Array<TextBox>} - Detected boxes with their scores
+     */
+    detectBoxes(input, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        return this._engine.detectBoxes(batchArgs([input])[0], options);
+    }
+
+    /**
+     * Detect text boxes only without blocking the event loop
+     * @param {string|Buffer} input - Image file path or encoded image Buffer, copied before the call returns
+     * @param {DetectOptions} [options] - compact/signal/timeout as for detectAsync()
+     * @returns {Promise<Array<TextBox>>} - Resolves with the detected boxes
+     */
+    async detectBoxesAsync(input, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        const [source] = batchArgs([input]);
+        return withSignal(options, (opts) => this._engine.detectBoxesAsync(source, opts));
+    }
+
+    /**
+     * Recognize already cropped text lines, skipping detection
+     * @param {Array<string|Buffer>} crops - One text line per image file path or encoded image Buffer
+     * @param {DetectOptions} [options] - compact/timeout as for detect()
+     * @returns {Array<OCRResult>} - One result per crop, the box covers the whole crop
+     */
+    recognize(crops, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        return this._engine.recognize(batchArgs(crops), options);
+    }
+
+    /**
+     * Recognize already cropped text lines without blocking the event loop
+     * @param {Array<string|Buffer>} crops - One text line per image file path or encoded image Buffer, copied before the call returns
+     * @param {DetectOptions} [options] - compact/signal/timeout as for detectAsync()
+     * @returns {Promise<Array<OCRResult>>} - Resolves with one result per crop
+     */
+    async recognizeAsync(crops, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        const sources = batchArgs(crops);
+        return withSignal(options, (opts) => this._engine.recognizeAsync(sources, opts));
+    }
+
+    /**
+     * Detect text and yield each line as soon as it is recognized, without
+     * waiting for the rest of the page. Lines arrive out of order; each one
+     * carries its position in the final results as `index`.
+     * @param {string|Buffer} input - Image file path or encoded image Buffer, copied before the call returns
+     * @param {DetectOptions} [options] - signal/timeout end the stream early
+     * @returns {AsyncGenerator<StreamedOCRResult>}
+     */
+    async *detectStream(input, options) {
+        if (!this._initialized) {
+            throw new Error('OCR engine not initialized. Call init() first.');
+        }
+        const [source] = batchArgs([input]);
+
+        // stops the native run when the consumer leaves the loop early,
+        // and follows the caller's signal
+        const controller = new AbortController();
+        const signal = options && options.signal;
+        const onAbort = () => controller.abort();
+        if (signal) {
+            if (signal.aborted) {
+                controller.abort();
+            } else {
+                signal.addEventListener('abort', onAbort, { once: true });
+            }
+        }
+
+        const queue = [];
+        let finished = false;
+        let closed = false;
+        let failure = null;
+        let wake = null;
+        const notify = () => {
+            if (wake) {
+                wake();
+                wake = null;
+            }
+        };
+
+        withSignal({ ...options, signal: controller.signal }, (opts) => this._engine.detectStream(source, (result) => {
+            if (!closed) {
+                queue.push(result);
+                notify();
+            }
+        }, opts)).then(() => {
+            finished = true;
+            notify();
+        }, (err) => {
+            failure = err;
+            finished = true;
+            notify();
+        });
+
+        try {
+            for (;;) {
+                if (queue.length > 0) {
+                    yield queue.shift();
+                } else if (failure) {
+                    throw failure;
+                } else if (finished) {
+                    return;
+                } else {
+                    await new Promise((resolve) => { wake = resolve; });
+                }
+            }
+        } finally {
+            closed = true;
+            if (signal) {
+                signal.removeEventListener('abort', onAbort);
+            }
+            if (!finished) {
+                controller.abort();
+            }
+        }
+    }
+
+    /**
+     * Get the queue depths of the pipelined runs of this engine
+     * @returns {PipelineStats}
+     */
+    pipelineStats() {
+        return this._engine.pipelineStats();
     }
 
     /**
@@ -156,6 +454,32 @@ class PaddleOCR {
     }
 }
 
+/**
+ * Expand compact results into regular OCRResult objects
+ * @param {CompactResults} compact - Results returned with { compact: true }
+ * @returns {Array<OCRResult>}
+ */
+function expandCompactResults(compact) {
+    const results = new Array(compact.count);
+    for (let i = 0; i < compact.count; i++) {
+        const box = [];
+        for (let j = 0; j < 4; j++) {
+            box.push({ x: compact.boxes[i * 8 + j * 2], y: compact.boxes[i * 8 + j * 2 + 1] });
+        }
+        results[i] = {
+            text: compact.text.toString('utf8', compact.textOffsets[i], compact.textOffsets[i + 1]),
+            charScores: Array.from(compact.charScores.subarray(compact.charOffsets[i], compact.charOffsets[i + 1])),
+            box,
+            boxScore: compact.boxScores[i],
+            angle: {
+                isRotated: compact.rotated[i] === 1,
+                score: compact.angleScores[i]
+            }
+        };
+    }
+    return results;
+}
+
 /**
  * Create a new PaddleOCR instance
  * @param {string} [configPath] - Optional config path to auto-initialize
@@ -169,9 +493,32 @@ function createOCR(configPath) {
     return ocr;
 }
 
+/**
+ * Limit how many detections run at the same time across all engines of the
+ * process, including engines in other worker_threads
+ * @param {number} maxConcurrency - Maximum number of concurrent runs, 0 for unlimited
+ */
+function setMaxConcurrency(maxConcurrency) {
+    if (!Number.isInteger(maxConcurrency) || maxConcurrency < 0) {
+        throw new Error('Expected a non-negative integer');
+    }
+    binding.setMaxConcurrency(maxConcurrency);
+}
+
+/**
+ * Get the process-wide limit of concurrent detections
+ * @returns {number} - Maximum number of concurrent runs, 0 for unlimited
+ */
+function getMaxConcurrency() {
+    return binding.getMaxConcurrency();
+}
+
 module.exports = {
     PaddleOCR,
     createOCR,
+    expandCompactResults,
+    setMaxConcurrency,
+    getMaxConcurrency,
     // Also export the raw binding for advanced usage
     _binding: binding
 };
@@ -3,6 +3,8 @@
 
 #include "plog/Log.h"
 
+#include "model_pool.h"
+#include "utils.h"
 #include "angle_net.h"
 
 namespace OCR
@@ -16,6 +18,7 @@ AngleNet::AngleNet(const ClsConfig &config)
 AngleNet::AngleNet(AngleNet &&other) noexcept
     : config_(std::exchange(other.config_, {}))
     , net_(std::move(other.net_))
+    , pool_(std::move(other.pool_))
 {
 
 }
@@ -26,33 +29,31 @@ AngleNet & AngleNet::operator = (AngleNet &&other) noexcept
     {
         config_ = std::exchange(other.config_, {});
         net_ = std::move(other.net_);
+        pool_ = std::move(other.pool_);
     }
     return *this;
 }
 
-bool AngleNet::Initialize(const ClsConfig &config)
+bool AngleNet::Initialize(const ClsConfig &config, std::shared_ptr<ThreadPool> pool)
 {
     config_ = config;
+    pool_ = pool ? std::move(pool) : std::make_shared<ThreadPool>(1);
 
-    // create net
-    net_ = std::make_unique<ncnn::Net>();
-    net_->opt.num_threads = config_.infer_threads;
-    net_->opt.use_fp16_packed = config_.is_fp16;
-    net_->opt.use_fp16_storage = config_.is_fp16;
-    net_->opt.use_fp16_arithmetic = config_.is_fp16;
-
-    if (net_->load_param((config_.model_path + ".param").c_str()) ||
-        net_->load_model((config_.model_path + ".bin").c_str()))
-    {
-        PLOGE << "Failed to load model " << config_.model_path;
-        net_.reset();
+    // get net, shared with other engines using the same model
+    net_ = ModelPool::Instance().GetNet(config_.model_path, config_.is_fp16);
+    if (!net_)
         return false;
-    }
 
     return true;
 }
 
 std::vector<Angle> AngleNet::Cls(const std::vector<cv::Mat> &text_images) const
+{
+    return Cls(text_images, {0, text_images.size()}, {});
+}
+
+std::vector<Angle> AngleNet::Cls(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &offsets,
+    const std::vector<float> &box_scores, const CancelToken *cancel) const
 {
     std::vector<Angle> angles(text_images.size());
     if (!config_.enable || text_images.empty())
@@ -62,49 +63,201 @@ std::vector<Angle> AngleNet::Cls(const std::vector<cv::Mat> &text_images) const
         return angles;
     }
 
-    // get angles
-    #pragma omp parallel for num_threads(config_.reco_threads) schedule(static)
-    for (size_t i = 0; i < text_images.size(); ++i)
+    if (config_.most_angle && config_.vote_lines > 0)
     {
-        angles[i] = Cls(text_images[i]);
+        ClsVoting(text_images, offsets, box_scores, angles, cancel);
+        return angles;
     }
 
+    // get angles, longest crops first since they take the longest to resize
+    ClsLines(text_images, GetLongestFirstOrder(text_images), angles, cancel);
+
     // vote for rotation decisions
     if (config_.most_angle)
     {
-        float rot_weight = 0.0f;
-        float no_rot_weight = 0.0f;
-        for (const auto &angle : angles)
+        for (size_t k = 0; k + 1 < offsets.size(); ++k)
         {
-            if (angle.is_rot)
-                rot_weight += angle.score;
-            else
-                no_rot_weight += angle.score;
+            float rot_weight = 0.0f;
+            float no_rot_weight = 0.0f;
+            for (size_t i = offsets[k]; i < offsets[k + 1]; ++i)
+            {
+                if (angles[i].is_rot)
+                    rot_weight += angles[i].score;
+                else
+                    no_rot_weight += angles[i].score;
+            }
+            bool decision = rot_weight > no_rot_weight;
+            for (size_t i = offsets[k]; i < offsets[k + 1]; ++i)
+                angles[i].is_rot = decision;
         }
-        bool decision = rot_weight > no_rot_weight;
-        for (auto &angle : angles)
-            angle.is_rot = decision;
     }
 
     return angles;
 }
 
-Angle AngleNet::Cls(const cv::Mat &image) const
+std::vector<Angle> AngleNet::Classify(const std::vector<cv::Mat> &text_images, const CancelToken *cancel) const
 {
-    // resize image
-    cv::Mat rsz_image = SmartResize(image, 3.0f);
+    std::vector<Angle> angles(text_images.size(), Angle{false, 0.0f});
+    ClsLines(text_images, GetLongestFirstOrder(text_images), angles, cancel);
+    return angles;
+}
 
-    ncnn::Mat blob = ncnn::Mat::from_pixels(rsz_image.data, ncnn::Mat::PIXEL_RGB, rsz_image.cols, rsz_image.rows);
-    blob.substract_mean_normalize(mean_values_, norm_values_);
+void AngleNet::ClsLines(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &order,
+    std::vector<Angle> &angles, const CancelToken *cancel) const
+{
+    // smaller batches while there are fewer lines than batch_size per core
+    const size_t per_core = (order.size() + pool_->Size() - 1) / pool_->Size();
+    const size_t batch_size = std::max<size_t>(1, std::min<size_t>(config_.batch_size, per_core));
+    std::vector<size_t> batches((order.size() + batch_size - 1) / batch_size);
+    for (size_t b = 0; b < batches.size(); ++b)
+        batches[b] = b;
+
+    // cores not needed for batches go to ncnn
+    const int infer_threads = std::min(config_.infer_threads, pool_->ThreadsPerTask(batches.size()));
+    pool_->ParallelFor(batches, [&](size_t b)
+    {
+        ClsBatch(text_images, order, b * batch_size, std::min(order.size(), (b + 1) * batch_size),
+            infer_threads, angles, cancel);
+    });
+}
+
+void AngleNet::ClsVoting(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &offsets,
+    const std::vector<float> &box_scores, std::vector<Angle> &angles, const CancelToken *cancel) const
+{
+    struct Vote
+    {
+        std::vector<size_t> lines;      // by descending box score
+        size_t next{0};
+        float weights[2]{0.0f, 0.0f};   // no_rot, rot
+        int confident[2]{0, 0};
+        bool decided{false};
+    };
+
+    std::vector<Vote> votes(offsets.size() - 1);
+    for (size_t k = 0; k < votes.size(); ++k)
+    {
+        Vote &vote = votes[k];
+        for (size_t i = offsets[k]; i < offsets[k + 1]; ++i)
+            vote.lines.emplace_back(i);
+        if (!box_scores.empty())
+        {
+            std::stable_sort(vote.lines.begin(), vote.lines.end(), [&box_scores](size_t a, size_t b)
+            {
+                return box_scores[a] > box_scores[b];
+            });
+        }
+        vote.decided = vote.lines.empty();
+    }
+
+    // every round takes the next lines of each undecided image, enough to keep the pool busy
+    const size_t round_lines = std::max<size_t>(config_.vote_lines, pool_->Size());
+    std::vector<uint8_t> classified(text_images.size(), 0);
+    for (;;)
+    {
+        std::vector<size_t> round;
+        for (Vote &vote : votes)
+        {
+            for (size_t n = 0; n < round_lines && !vote.decided && vote.next < vote.lines.size(); ++n)
+                round.emplace_back(vote.lines[vote.next++]);
+        }
+        if (round.empty() || (cancel && cancel->Expired()))
+            break;
+
+        ClsLines(text_images, round, angles, cancel);
+        if (cancel && cancel->Interrupted())
+            break;
+
+        for (size_t i : round)
+            classified[i] = 1;
+
+        for (Vote &vote : votes)
+        {
+            if (vote.decided)
+                continue;
+
+            vote.weights[0] = vote.weights[1] = 0.0f;
+            vote.confident[0] = vote.confident[1] = 0;
+            for (size_t n = 0; n < vote.next; ++n)
+            {
+                const Angle &angle = angles[vote.lines[n]];
+                vote.weights[angle.is_rot] += angle.score;
+                vote.confident[angle.is_rot] += angle.score >= config_.vote_thres;
+            }
+
+            // each remaining line adds at most 1 to either side, so a larger lead
+            // is the result of the full vote; K confident lines without a single
+            // confident dissent are taken as decided as well
+            const int lead = vote.weights[1] > vote.weights[0];
+            const float margin = vote.weights[lead] - vote.weights[1 - lead];
+            vote.decided = vote.next == vote.lines.size() ||
+                margin > static_cast<float>(vote.lines.size() - vote.next) ||
+                (vote.confident[lead] >= config_.vote_lines && vote.confident[1 - lead] == 0);
+        }
+    }
+
+    // apply the vote, lines skipped by an early stop get the mean score of the winning side
+    for (Vote &vote : votes)
+    {
+        const bool decision = vote.weights[1] > vote.weights[0];
+        int count = 0;
+        for (size_t n = 0; n < vote.next; ++n)
+            count += angles[vote.lines[n]].is_rot == decision;
+        const float score = count > 0 ? vote.weights[decision] / count : 0.0f;
+
+        for (size_t i : vote.lines)
+        {
+            if (!classified[i])
+                angles[i].score = score;
+            angles[i].is_rot = decision;
+        }
+    }
+}
+
+void AngleNet::ClsBatch(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &order,
+    const size_t begin, const size_t end, const int infer_threads, std::vector<Angle> &angles,
+    const CancelToken *cancel) const
+{
+    // ncnn has no batch axis: the lines of a batch run on one extractor, cleared
+    // between lines, whose pooled allocators hand the buffers of the previous line
+    // to the next; each inference is the same as on its own extractor. Inputs are
+    // target_w_ x target_h_ except lines narrower than target_w_, which SmartResize
+    // pads to a wider input. Blobs are only allocated on this thread, workspace also
+    // on ncnn's threads with infer_threads > 1
+    ncnn::UnlockedPoolAllocator blob_allocator;
+    ncnn::PoolAllocator workspace_allocator;
 
-    // inference
     ncnn::Extractor ex = net_->create_extractor();
-    ex.input("input", blob);
-    ncnn::Mat out;
-    ex.extract("output", out);
+    ex.set_num_threads(infer_threads);
+    ex.set_blob_allocator(&blob_allocator);
+    ex.set_workspace_allocator(&workspace_allocator);
+
+    for (size_t j = begin; j < end; ++j)
+    {
+        if (cancel && cancel->Expired())
+            return;
+
+        // resize image
+        cv::Mat rsz_image = SmartResize(text_images[order[j]], 3.0f);
 
+        // the pool hands back the tensor of an earlier line of the same size
+        ncnn::Mat blob = ncnn::Mat::from_pixels(rsz_image.data, ncnn::Mat::PIXEL_RGB, rsz_image.cols, rsz_image.rows,
+            &blob_allocator);
+        blob.substract_mean_normalize(mean_values_, norm_values_);
+
+        // inference
+        ex.clear();
+        ex.input("input", blob);
+        ncnn::Mat out;
+        ex.extract("output", out);
+
+        angles[order[j]] = ScoreToAngle(out);
+    }
+}
+
+Angle AngleNet::ScoreToAngle(const ncnn::Mat &out) const
+{
     // socre to angle
-    float *arr = reinterpret_cast<float *>(out.data);
+    const float *arr = reinterpret_cast<const float *>(out.data);
     std::vector<float> scores(arr, arr + out.w);
 
     auto max_it = std::max_element(scores.begin(), scores.end());
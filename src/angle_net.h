@@ -9,6 +9,8 @@
 
 #include "common.h"
 #include "config.h"
+#include "cancel_token.h"
+#include "thread_pool.h"
 
 namespace OCR
 {
@@ -28,19 +30,43 @@ public:
     AngleNet(const AngleNet &) = delete;
     AngleNet & operator = (const AngleNet &) = delete;
 
-    bool Initialize(const ClsConfig &config);
+    // lines run on pool, a single-threaded pool is used without one
+    bool Initialize(const ClsConfig &config, std::shared_ptr<ThreadPool> pool = nullptr);
 
     std::vector<Angle> Cls(const std::vector<cv::Mat> &text_images) const;
 
+    // text_images[offsets[k], offsets[k + 1]) belong to image k, most_angle votes per image;
+    // with vote_lines the vote starts at the highest box_scores and stops once decided;
+    // once cancel expires the remaining lines are skipped and the angles are incomplete
+    std::vector<Angle> Cls(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &offsets,
+        const std::vector<float> &box_scores, const CancelToken *cancel = nullptr) const;
+
+    // per-line angles without voting, also when enable is false
+    std::vector<Angle> Classify(const std::vector<cv::Mat> &text_images, const CancelToken *cancel = nullptr) const;
+
 private:
     ClsConfig config_{};
-    std::unique_ptr<ncnn::Net> net_{};
+    std::shared_ptr<const ncnn::Net> net_{};
+    std::shared_ptr<ThreadPool> pool_{};
 
     static inline const int target_w_ = 192, target_h_ = 48;
     static inline const float mean_values_[3]{127.5f, 127.5f, 127.5f};
     static inline const float norm_values_[3]{1.0f / 127.5f, 1.0f / 127.5f, 1.0f / 127.5f};
 
-    Angle Cls(const cv::Mat &image) const;
+    // classifies text_images[order] in batches on the pool
+    void ClsLines(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &order,
+        std::vector<Angle> &angles, const CancelToken *cancel) const;
+
+    // classifies rounds of lines per image until each vote is decided
+    void ClsVoting(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &offsets,
+        const std::vector<float> &box_scores, std::vector<Angle> &angles, const CancelToken *cancel) const;
+
+    // classifies text_images[order[begin, end)] with one extractor and one input tensor
+    void ClsBatch(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &order,
+        const size_t begin, const size_t end, const int infer_threads, std::vector<Angle> &angles,
+        const CancelToken *cancel) const;
+
+    Angle ScoreToAngle(const ncnn::Mat &out) const;
 
     cv::Mat SmartResize(const cv::Mat &image, const float max_downscale) const;
 };
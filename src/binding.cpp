@@ -2,9 +2,175 @@
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
+#include <mutex>
 #include <memory>
+#include <utility>
+#include <algorithm>
+#include <chrono>
 
 #include "ocr_engine.h"
+#include "model_pool.h"
+#include "cancel_token.h"
+
+enum class PixelFormat
+{
+    kNone,  // data is an encoded image (PNG, JPEG, ...)
+    kBGR,
+    kRGB,
+    kBGRA,
+    kGRAY
+};
+
+// Image input of a detection. Decoding happens in Load() so that async
+// detections read and decode the image off the JS thread.
+struct ImageSource
+{
+    std::string path;
+    const uint8_t *data{nullptr};
+    size_t size{0};
+
+    // layout of raw pixel data
+    PixelFormat format{PixelFormat::kNone};
+    int width{0};
+    int height{0};
+    size_t stride{0};
+
+    // data lives in a SharedArrayBuffer, which cannot be detached
+    bool shared{false};
+    std::shared_ptr<std::vector<uint8_t>> owned{};
+
+    // copies data before an async run: a plain ArrayBuffer can be transferred or
+    // detached while the worker still reads it, keeping the view alive does not
+    // prevent that. Shared memory is read in place
+    void Own()
+    {
+        if (data == nullptr || shared || owned)
+            return;
+        owned = std::make_shared<std::vector<uint8_t>>(data, data + size);
+        data = owned->data();
+    }
+
+    cv::Mat Load(std::string &error) const
+    {
+        cv::Mat image;
+        if (format != PixelFormat::kNone)
+        {
+            // wrap the caller's pixels as a cv::Mat header, BGR frames are used as is
+            void *pixels = const_cast<uint8_t *>(data);
+            switch (format)
+            {
+            case PixelFormat::kBGR:
+                image = cv::Mat(height, width, CV_8UC3, pixels, stride);
+                break;
+            case PixelFormat::kRGB:
+                cv::cvtColor(cv::Mat(height, width, CV_8UC3, pixels, stride), image, cv::COLOR_RGB2BGR);
+                break;
+            case PixelFormat::kBGRA:
+                cv::cvtColor(cv::Mat(height, width, CV_8UC4, pixels, stride), image, cv::COLOR_BGRA2BGR);
+                break;
+            case PixelFormat::kGRAY:
+                cv::cvtColor(cv::Mat(height, width, CV_8UC1, pixels, stride), image, cv::COLOR_GRAY2BGR);
+                break;
+            default:
+                break;
+            }
+        }
+        else if (data != nullptr)
+        {
+            // wrap the buffer without copying, imdecode only reads it
+            cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t *>(data));
+            image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+            if (image.empty())
+                error = "Failed to decode image buffer";
+        }
+        else
+        {
+            image = cv::imread(path);
+            if (image.empty())
+                error = "Failed to read image: " + path;
+        }
+        return image;
+    }
+};
+
+// Async runs of one environment waiting for a ModelPool run slot. A slot is
+// granted on whichever thread frees one, queue_worker brings the run back to the
+// JS thread to be queued, so waiting runs never hold a libuv thread.
+struct RunAdmission
+{
+    std::mutex mutex;
+    bool alive{true};       // false once the environment is torn down
+    Napi::ThreadSafeFunction queue_worker;
+    size_t waiting{0};      // runs not yet admitted, they keep the event loop alive
+};
+
+// Per-environment class constructors, each worker_thread gets its own.
+struct AddonData
+{
+    Napi::FunctionReference engine_constructor;
+    Napi::FunctionReference cancel_token_constructor;
+    std::shared_ptr<RunAdmission> admission;
+
+    ~AddonData()
+    {
+        std::lock_guard<std::mutex> lock(admission->mutex);
+        admission->alive = false;
+    }
+};
+
+// Part of the pipeline a detection call runs.
+enum class RunMode
+{
+    kFull,      // OCREngine::RunBatch
+    kBoxes,     // OCREngine::DetectBoxes, results only carry boxes
+    kLines      // OCREngine::RunLines, every input is one text line
+};
+
+// How a detection call runs and returns its results.
+struct DetectOptions
+{
+    RunMode mode{RunMode::kFull};
+    // one result list per input (detectMany) instead of all results in one list
+    bool batch{false};
+    // typed-array encoding of the results, see ResultsToCompact
+    bool compact{false};
+    // set by a timeout or a JS CancelToken, stops the run early
+    std::shared_ptr<OCR::CancelToken> cancel{};
+};
+
+// JS handle to cancel a running detection, passed as options.cancelToken.
+class CancelTokenWrapper : public Napi::ObjectWrap<CancelTokenWrapper>
+{
+public:
+    static Napi::Function Init(Napi::Env env);
+    CancelTokenWrapper(const Napi::CallbackInfo &info);
+
+    std::shared_ptr<OCR::CancelToken> Token() const { return token_; }
+
+private:
+    std::shared_ptr<OCR::CancelToken> token_;
+
+    Napi::Value Cancel(const Napi::CallbackInfo &info);
+};
+
+Napi::Function CancelTokenWrapper::Init(Napi::Env env)
+{
+    return DefineClass(env, "CancelToken", {
+        InstanceMethod("cancel", &CancelTokenWrapper::Cancel),
+    });
+}
+
+CancelTokenWrapper::CancelTokenWrapper(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<CancelTokenWrapper>(info)
+{
+    token_ = std::make_shared<OCR::CancelToken>();
+}
+
+Napi::Value CancelTokenWrapper::Cancel(const Napi::CallbackInfo &info)
+{
+    token_->Cancel();
+    return info.Env().Undefined();
+}
 
 class OCREngineWrapper : public Napi::ObjectWrap<OCREngineWrapper>
 {
@@ -12,15 +178,279 @@ public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     OCREngineWrapper(const Napi::CallbackInfo &info);
 
+    // Helpers to convert OCRResult to JS objects
+    static Napi::Object ResultToObject(Napi::Env env, const OCR::OCRResult &result);
+    static Napi::Array ResultsToArray(Napi::Env env, const std::vector<OCR::OCRResult> &results);
+    static Napi::Array BoxesToArray(Napi::Env env, const std::vector<OCR::OCRResult> &results);
+    static Napi::Array BoxToArray(Napi::Env env, const OCR::TextBox &box);
+    static Napi::Object ResultsToCompact(Napi::Env env, const std::vector<OCR::OCRResult> &results);
+    static Napi::Value ResultsToValue(Napi::Env env, const std::vector<std::vector<OCR::OCRResult>> &results,
+        const DetectOptions &options);
+    static bool IsPartial(const DetectOptions &options);
+
 private:
-    std::unique_ptr<OCR::OCREngine> engine_;
+    // shared with in-flight async detections, replaced as a whole by initialize()
+    std::shared_ptr<const OCR::OCREngine> engine_;
 
     Napi::Value Initialize(const Napi::CallbackInfo &info);
     Napi::Value Detect(const Napi::CallbackInfo &info);
     Napi::Value DetectBuffer(const Napi::CallbackInfo &info);
+    Napi::Value DetectAsync(const Napi::CallbackInfo &info);
+    Napi::Value DetectBufferAsync(const Napi::CallbackInfo &info);
+    Napi::Value DetectPixels(const Napi::CallbackInfo &info);
+    Napi::Value DetectPixelsAsync(const Napi::CallbackInfo &info);
 
-    // Helper to convert OCRResult to JS object
-    static Napi::Object ResultToObject(Napi::Env env, const OCR::OCRResult &result);
+    Napi::Value DetectMany(const Napi::CallbackInfo &info);
+    Napi::Value DetectManyAsync(const Napi::CallbackInfo &info);
+    Napi::Value DetectStream(const Napi::CallbackInfo &info);
+    Napi::Value DetectBoxes(const Napi::CallbackInfo &info);
+    Napi::Value DetectBoxesAsync(const Napi::CallbackInfo &info);
+    Napi::Value Recognize(const Napi::CallbackInfo &info);
+    Napi::Value RecognizeAsync(const Napi::CallbackInfo &info);
+    Napi::Value PipelineStats(const Napi::CallbackInfo &info);
+
+    static DetectOptions ParseOptions(const Napi::CallbackInfo &info, size_t index);
+    static bool ParsePixels(const Napi::CallbackInfo &info, ImageSource &source);
+    static bool ParseSources(const Napi::CallbackInfo &info, std::vector<ImageSource> &sources, Napi::Array &keep_alive);
+
+    Napi::Value RunSync(Napi::Env env, const std::vector<ImageSource> &sources, const DetectOptions &options) const;
+    Napi::Value RunAsync(Napi::Env env, std::vector<ImageSource> sources, Napi::Value keep_alive,
+        const DetectOptions &options) const;
+};
+
+// Image path or encoded image buffer, false for any other value.
+static bool ToImageSource(const Napi::Value &input, ImageSource &source)
+{
+    if (input.IsString())
+    {
+        source.path = input.As<Napi::String>().Utf8Value();
+        return true;
+    }
+    if (input.IsBuffer())
+    {
+        Napi::Buffer<uint8_t> buffer = input.As<Napi::Buffer<uint8_t>>();
+        source.data = buffer.Data();
+        source.size = buffer.Length();
+        return true;
+    }
+    return false;
+}
+
+// Runs the part of the pipeline selected by options.mode, one result list per image.
+static std::vector<std::vector<OCR::OCRResult>> RunEngine(const OCR::OCREngine &engine,
+    const std::vector<cv::Mat> &images, const DetectOptions &options,
+    const OCR::OCREngine::ResultCallback &on_result = nullptr)
+{
+    if (options.mode == RunMode::kLines)
+        return engine.RunLines(images, on_result, options.cancel.get());
+
+    if (options.mode == RunMode::kBoxes)
+    {
+        std::vector<std::vector<OCR::OCRResult>> results(images.size());
+        for (size_t k = 0; k < images.size(); ++k)
+        {
+            if (options.cancel && options.cancel->Expired())
+                break;
+            for (auto &box : engine.DetectBoxes(images[k]))
+                results[k].emplace_back(OCR::OCRResult{std::move(box), OCR::Angle{false, 0.0f}, OCR::TextLine{}});
+        }
+        return results;
+    }
+
+    return engine.RunBatch(images, on_result, options.cancel.get());
+}
+
+// Loads every source, fails on the first one that cannot be decoded.
+static bool LoadImages(const std::vector<ImageSource> &sources, std::vector<cv::Mat> &images, std::string &error)
+{
+    images.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        images[i] = sources[i].Load(error);
+        if (images[i].empty())
+            return false;
+    }
+    return true;
+}
+
+// Queues worker on the libuv thread pool once ModelPool admits another run, the
+// worker adopts the slot in Execute. Runs over setMaxConcurrency wait in ModelPool
+// instead of blocking a pool thread, which would starve UV_THREADPOOL_SIZE.
+template <typename Worker>
+static void QueueAdmitted(Napi::Env env, Worker *worker)
+{
+    std::shared_ptr<RunAdmission> admission = env.GetInstanceData<AddonData>()->admission;
+
+    auto on_free = [admission, worker]
+    {
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(admission->mutex);
+            if (admission->alive)
+            {
+                queued = admission->queue_worker.NonBlockingCall(worker,
+                    [admission](Napi::Env env, Napi::Function, Worker *admitted)
+                    {
+                        if (--admission->waiting == 0)
+                            admission->queue_worker.Unref(env);
+                        admitted->Queue();
+                    }) == napi_ok;
+            }
+        }
+
+        // the environment is gone, pass the slot on
+        if (!queued)
+        {
+            OCR::ModelPool::RunSlot slot(std::adopt_lock);
+        }
+    };
+
+    if (OCR::ModelPool::Instance().TryAcquireSlot(on_free))
+    {
+        worker->Queue();
+        return;
+    }
+
+    if (admission->waiting++ == 0)
+        admission->queue_worker.Ref(env);
+}
+
+// Runs decode and the OCREngine pipeline on the libuv thread pool and settles a
+// promise with the results, which are only converted to JS values in OnOK.
+class DetectWorker : public Napi::AsyncWorker
+{
+public:
+    DetectWorker(Napi::Env env, std::shared_ptr<const OCR::OCREngine> engine,
+        std::vector<ImageSource> sources, Napi::Value keep_alive, const DetectOptions &options)
+        : Napi::AsyncWorker(env, "PaddleOCR:detect")
+        , engine_(std::move(engine))
+        , sources_(std::move(sources))
+        , options_(options)
+        , deferred_(Napi::Promise::Deferred::New(env))
+    {
+        for (auto &source : sources_)
+            source.Own();
+
+        // hold shared input memory until the worker has finished reading it
+        if (keep_alive.IsObject())
+            keep_alive_ = Napi::Persistent(keep_alive.As<Napi::Object>());
+    }
+
+    Napi::Promise Promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override
+    {
+        OCR::ModelPool::RunSlot slot(std::adopt_lock);
+
+        std::string error;
+        std::vector<cv::Mat> images;
+        if (!LoadImages(sources_, images, error))
+        {
+            SetError(error);
+            return;
+        }
+        results_ = RunEngine(*engine_, images, options_);
+    }
+
+    void OnOK() override
+    {
+        deferred_.Resolve(OCREngineWrapper::ResultsToValue(Env(), results_, options_));
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    std::shared_ptr<const OCR::OCREngine> engine_;
+    std::vector<ImageSource> sources_;
+    DetectOptions options_;
+    Napi::ObjectReference keep_alive_;
+    Napi::Promise::Deferred deferred_;
+    std::vector<std::vector<OCR::OCRResult>> results_;
+};
+
+// A recognized line and its position in the final results.
+struct StreamItem
+{
+    size_t index;
+    OCR::OCRResult result;
+};
+
+// Like DetectWorker, but also hands every line to a JS callback as soon as
+// CRNNNet has recognized it. Lines arrive out of order, each carries its index.
+class StreamWorker : public Napi::AsyncProgressQueueWorker<StreamItem>
+{
+public:
+    StreamWorker(Napi::Env env, std::shared_ptr<const OCR::OCREngine> engine,
+        ImageSource source, Napi::Value keep_alive, Napi::Function on_result, const DetectOptions &options)
+        : Napi::AsyncProgressQueueWorker<StreamItem>(env, "PaddleOCR:detectStream")
+        , engine_(std::move(engine))
+        , source_(std::move(source))
+        , options_(options)
+        , on_result_(Napi::Persistent(on_result))
+        , deferred_(Napi::Promise::Deferred::New(env))
+    {
+        source_.Own();
+
+        if (keep_alive.IsObject())
+            keep_alive_ = Napi::Persistent(keep_alive.As<Napi::Object>());
+    }
+
+    Napi::Promise Promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute(const ExecutionProgress &progress) override
+    {
+        OCR::ModelPool::RunSlot slot(std::adopt_lock);
+
+        std::string error;
+        cv::Mat image = source_.Load(error);
+        if (image.empty())
+        {
+            SetError(error);
+            return;
+        }
+
+        // Send() is thread-safe, rec threads queue their lines directly
+        results_ = RunEngine(*engine_, {image}, options_, [&progress](size_t, size_t i, const OCR::OCRResult &result)
+        {
+            StreamItem item{i, result};
+            progress.Send(&item, 1);
+        });
+    }
+
+    void OnProgress(const StreamItem *items, size_t count) override
+    {
+        Napi::Env env = Env();
+        for (size_t i = 0; i < count; ++i)
+        {
+            Napi::Object obj = OCREngineWrapper::ResultToObject(env, items[i].result);
+            obj.Set("index", Napi::Number::New(env, static_cast<double>(items[i].index)));
+            on_result_.Call({obj});
+        }
+    }
+
+    void OnOK() override
+    {
+        deferred_.Resolve(OCREngineWrapper::ResultsToValue(Env(), results_, options_));
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        deferred_.Reject(e.Value());
+    }
+
+private:
+    std::shared_ptr<const OCR::OCREngine> engine_;
+    ImageSource source_;
+    DetectOptions options_;
+    Napi::ObjectReference keep_alive_;
+    Napi::FunctionReference on_result_;
+    Napi::Promise::Deferred deferred_;
+    std::vector<std::vector<OCR::OCRResult>> results_;
 };
 
 Napi::Object OCREngineWrapper::Init(Napi::Env env, Napi::Object exports)
@@ -29,20 +459,40 @@ Napi::Object OCREngineWrapper::Init(Napi::Env env, Napi::Object exports)
         InstanceMethod("initialize", &OCREngineWrapper::Initialize),
         InstanceMethod("detect", &OCREngineWrapper::Detect),
         InstanceMethod("detectBuffer", &OCREngineWrapper::DetectBuffer),
+        InstanceMethod("detectAsync", &OCREngineWrapper::DetectAsync),
+        InstanceMethod("detectBufferAsync", &OCREngineWrapper::DetectBufferAsync),
+        InstanceMethod("detectPixels", &OCREngineWrapper::DetectPixels),
+        InstanceMethod("detectPixelsAsync", &OCREngineWrapper::DetectPixelsAsync),
+        InstanceMethod("detectMany", &OCREngineWrapper::DetectMany),
+        InstanceMethod("detectManyAsync", &OCREngineWrapper::DetectManyAsync),
+        InstanceMethod("detectStream", &OCREngineWrapper::DetectStream),
+        InstanceMethod("detectBoxes", &OCREngineWrapper::DetectBoxes),
+        InstanceMethod("detectBoxesAsync", &OCREngineWrapper::DetectBoxesAsync),
+        InstanceMethod("recognize", &OCREngineWrapper::Recognize),
+        InstanceMethod("recognizeAsync", &OCREngineWrapper::RecognizeAsync),
+        InstanceMethod("pipelineStats", &OCREngineWrapper::PipelineStats),
     });
 
-    Napi::FunctionReference *constructor = new Napi::FunctionReference();
-    *constructor = Napi::Persistent(func);
-    env.SetInstanceData(constructor);
+    Napi::Function cancel_token = CancelTokenWrapper::Init(env);
+
+    AddonData *data = new AddonData();
+    data->engine_constructor = Napi::Persistent(func);
+    data->cancel_token_constructor = Napi::Persistent(cancel_token);
+    data->admission = std::make_shared<RunAdmission>();
+    data->admission->queue_worker = Napi::ThreadSafeFunction::New(env,
+        Napi::Function::New(env, [](const Napi::CallbackInfo &) {}), "PaddleOCR:admission", 0, 1);
+    data->admission->queue_worker.Unref(env);
+    env.SetInstanceData(data);
 
     exports.Set("OCREngine", func);
+    exports.Set("CancelToken", cancel_token);
     return exports;
 }
 
 OCREngineWrapper::OCREngineWrapper(const Napi::CallbackInfo &info)
     : Napi::ObjectWrap<OCREngineWrapper>(info)
 {
-    engine_ = std::make_unique<OCR::OCREngine>();
+    engine_ = std::make_shared<OCR::OCREngine>();
 }
 
 Napi::Value OCREngineWrapper::Initialize(const Napi::CallbackInfo &info)
@@ -56,7 +506,11 @@ Napi::Value OCREngineWrapper::Initialize(const Napi::CallbackInfo &info)
     }
 
     std::string config_path = info[0].As<Napi::String>().Utf8Value();
-    bool success = engine_->Initialize(config_path);
+
+    // swap in a fresh engine so async detections still running keep the old one
+    auto engine = std::make_shared<OCR::OCREngine>();
+    bool success = engine->Initialize(config_path);
+    engine_ = std::move(engine);
 
     return Napi::Boolean::New(env, success);
 }
@@ -71,27 +525,48 @@ Napi::Value OCREngineWrapper::Detect(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
-    std::string image_path = info[0].As<Napi::String>().Utf8Value();
-    cv::Mat image = cv::imread(image_path);
+    ImageSource source;
+    source.path = info[0].As<Napi::String>().Utf8Value();
 
-    if (image.empty())
+    return RunSync(env, {source}, ParseOptions(info, 1));
+}
+
+Napi::Value OCREngineWrapper::DetectBuffer(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
     {
-        Napi::Error::New(env, "Failed to read image: " + image_path).ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Image buffer expected").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    auto results = engine_->Run(image);
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
 
-    Napi::Array result_array = Napi::Array::New(env, results.size());
-    for (size_t i = 0; i < results.size(); ++i)
+    ImageSource source;
+    source.data = buffer.Data();
+    source.size = buffer.Length();
+
+    return RunSync(env, {source}, ParseOptions(info, 1));
+}
+
+Napi::Value OCREngineWrapper::DetectAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
     {
-        result_array.Set(i, ResultToObject(env, results[i]));
+        Napi::TypeError::New(env, "Image path (string) expected").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    return result_array;
+    ImageSource source;
+    source.path = info[0].As<Napi::String>().Utf8Value();
+
+    return RunAsync(env, {std::move(source)}, env.Undefined(), ParseOptions(info, 1));
 }
 
-Napi::Value OCREngineWrapper::DetectBuffer(const Napi::CallbackInfo &info)
+Napi::Value OCREngineWrapper::DetectBufferAsync(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
@@ -102,18 +577,334 @@ Napi::Value OCREngineWrapper::DetectBuffer(const Napi::CallbackInfo &info)
     }
 
     Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
-    std::vector<uint8_t> data(buffer.Data(), buffer.Data() + buffer.Length());
 
-    cv::Mat image = cv::imdecode(data, cv::IMREAD_COLOR);
+    ImageSource source;
+    source.data = buffer.Data();
+    source.size = buffer.Length();
+
+    return RunAsync(env, {std::move(source)}, buffer, ParseOptions(info, 1));
+}
+
+Napi::Value OCREngineWrapper::DetectPixels(const Napi::CallbackInfo &info)
+{
+    ImageSource source;
+    if (!ParsePixels(info, source))
+        return info.Env().Null();
+
+    return RunSync(info.Env(), {source}, ParseOptions(info, 5));
+}
+
+Napi::Value OCREngineWrapper::DetectPixelsAsync(const Napi::CallbackInfo &info)
+{
+    ImageSource source;
+    if (!ParsePixels(info, source))
+        return info.Env().Null();
+
+    return RunAsync(info.Env(), {std::move(source)}, info[0], ParseOptions(info, 5));
+}
+
+// Arguments: (data: TypedArray, width, height, stride, format). The typed array
+// may be a view on a SharedArrayBuffer, its memory is read in place.
+bool OCREngineWrapper::ParsePixels(const Napi::CallbackInfo &info, ImageSource &source)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 5 || !info[0].IsTypedArray() || !info[1].IsNumber() || !info[2].IsNumber() ||
+        !info[3].IsNumber() || !info[4].IsString())
+    {
+        Napi::TypeError::New(env, "(data: TypedArray, width, height, stride, format) expected").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    // napi_get_typedarray_info also resolves views on SharedArrayBuffers,
+    // which Napi::TypedArray::ArrayBuffer() rejects
+    napi_typedarray_type type;
+    size_t length = 0;
+    void *data = nullptr;
+    napi_value buffer = nullptr;
+    if (napi_get_typedarray_info(env, info[0], &type, &length, &data, &buffer, nullptr) != napi_ok)
+    {
+        Napi::TypeError::New(env, "Failed to access pixel data").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    std::string format = info[4].As<Napi::String>().Utf8Value();
+    int channels = 0;
+    if (format == "bgr")
+    {
+        source.format = PixelFormat::kBGR;
+        channels = 3;
+    }
+    else if (format == "rgb")
+    {
+        source.format = PixelFormat::kRGB;
+        channels = 3;
+    }
+    else if (format == "bgra")
+    {
+        source.format = PixelFormat::kBGRA;
+        channels = 4;
+    }
+    else if (format == "gray")
+    {
+        source.format = PixelFormat::kGRAY;
+        channels = 1;
+    }
+    else
+    {
+        Napi::TypeError::New(env, "Unknown pixel format: " + format).ThrowAsJavaScriptException();
+        return false;
+    }
+
+    source.data = static_cast<const uint8_t *>(data);
+    source.size = length * info[0].As<Napi::TypedArray>().ElementSize();
+    source.shared = !Napi::Value(env, buffer).IsArrayBuffer();
+    source.width = info[1].As<Napi::Number>().Int32Value();
+    source.height = info[2].As<Napi::Number>().Int32Value();
+    source.stride = static_cast<size_t>(info[3].As<Napi::Number>().Int64Value());
+
+    const size_t row_bytes = static_cast<size_t>(source.width) * channels;
+    if (source.width <= 0 || source.height <= 0 || source.stride < row_bytes ||
+        source.size < source.stride * (source.height - 1) + row_bytes)
+    {
+        Napi::RangeError::New(env, "Pixel data does not match width, height and stride").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
+}
+
+Napi::Value OCREngineWrapper::DetectMany(const Napi::CallbackInfo &info)
+{
+    std::vector<ImageSource> sources;
+    Napi::Array keep_alive;
+    if (!ParseSources(info, sources, keep_alive))
+        return info.Env().Null();
+
+    DetectOptions options = ParseOptions(info, 1);
+    options.batch = true;
+
+    return RunSync(info.Env(), sources, options);
+}
+
+Napi::Value OCREngineWrapper::DetectManyAsync(const Napi::CallbackInfo &info)
+{
+    std::vector<ImageSource> sources;
+    Napi::Array keep_alive;
+    if (!ParseSources(info, sources, keep_alive))
+        return info.Env().Null();
+
+    DetectOptions options = ParseOptions(info, 1);
+    options.batch = true;
+
+    return RunAsync(info.Env(), std::move(sources), keep_alive, options);
+}
+
+// Arguments: (input: string | Buffer, onResult: Function, options?). onResult receives each
+// line with its index as soon as it is recognized, the returned promise resolves
+// with all results in order.
+Napi::Value OCREngineWrapper::DetectStream(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    ImageSource source;
+    if (info.Length() < 2 || !ToImageSource(info[0], source) || !info[1].IsFunction())
+    {
+        Napi::TypeError::New(env, "(input: string | Buffer, onResult: Function) expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // the worker deletes itself once the promise is settled
+    DetectOptions options = ParseOptions(info, 2);
+    options.compact = false;
+
+    StreamWorker *worker = new StreamWorker(env, engine_, std::move(source), info[0], info[1].As<Napi::Function>(), options);
+    Napi::Promise promise = worker->Promise();
+    QueueAdmitted(env, worker);
+
+    return promise;
+}
+
+// Arguments: (input: string | Buffer, options?). Resolves to [{ box, boxScore }].
+Napi::Value OCREngineWrapper::DetectBoxes(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    ImageSource source;
+    if (info.Length() < 1 || !ToImageSource(info[0], source))
+    {
+        Napi::TypeError::New(env, "Image path (string) or buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DetectOptions options = ParseOptions(info, 1);
+    options.mode = RunMode::kBoxes;
+
+    return RunSync(env, {source}, options);
+}
+
+Napi::Value OCREngineWrapper::DetectBoxesAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    ImageSource source;
+    if (info.Length() < 1 || !ToImageSource(info[0], source))
+    {
+        Napi::TypeError::New(env, "Image path (string) or buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DetectOptions options = ParseOptions(info, 1);
+    options.mode = RunMode::kBoxes;
+
+    return RunAsync(env, {std::move(source)}, info[0], options);
+}
+
+// Arguments: (crops: Array<string | Buffer>, options?). Each crop is one text
+// line, resolves to one result per recognized crop.
+Napi::Value OCREngineWrapper::Recognize(const Napi::CallbackInfo &info)
+{
+    std::vector<ImageSource> sources;
+    Napi::Array keep_alive;
+    if (!ParseSources(info, sources, keep_alive))
+        return info.Env().Null();
+
+    DetectOptions options = ParseOptions(info, 1);
+    options.mode = RunMode::kLines;
+
+    return RunSync(info.Env(), sources, options);
+}
+
+Napi::Value OCREngineWrapper::RecognizeAsync(const Napi::CallbackInfo &info)
+{
+    std::vector<ImageSource> sources;
+    Napi::Array keep_alive;
+    if (!ParseSources(info, sources, keep_alive))
+        return info.Env().Null();
+
+    DetectOptions options = ParseOptions(info, 1);
+    options.mode = RunMode::kLines;
+
+    return RunAsync(info.Env(), std::move(sources), keep_alive, options);
+}
+
+static Napi::Object QueueStatsToObject(Napi::Env env, const OCR::QueueStats &stats)
+{
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("capacity", Napi::Number::New(env, static_cast<double>(stats.capacity)));
+    obj.Set("maxDepth", Napi::Number::New(env, static_cast<double>(stats.max_depth)));
+    obj.Set("meanDepth", Napi::Number::New(env, stats.MeanDepth()));
+    obj.Set("fullWaits", Napi::Number::New(env, static_cast<double>(stats.full_waits)));
+    return obj;
+}
+
+Napi::Value OCREngineWrapper::PipelineStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    const OCR::PipelineStats stats = engine_->GetPipelineStats();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("runs", Napi::Number::New(env, static_cast<double>(stats.runs)));
+    obj.Set("images", Napi::Number::New(env, static_cast<double>(stats.images)));
+    obj.Set("clsQueue", QueueStatsToObject(env, stats.cls_queue));
+    obj.Set("recQueue", QueueStatsToObject(env, stats.rec_queue));
+    return obj;
+}
+
+// Arguments: (inputs: Array<string | Buffer>). keep_alive receives the
+// buffers so the caller may change the input array while a detection runs.
+bool OCREngineWrapper::ParseSources(const Napi::CallbackInfo &info, std::vector<ImageSource> &sources, Napi::Array &keep_alive)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsArray())
+    {
+        Napi::TypeError::New(env, "Array of image paths or buffers expected").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Array inputs = info[0].As<Napi::Array>();
+    keep_alive = Napi::Array::New(env, inputs.Length());
+    sources.resize(inputs.Length());
+    for (uint32_t i = 0; i < inputs.Length(); ++i)
+    {
+        Napi::Value input = inputs.Get(i);
+        if (!ToImageSource(input, sources[i]))
+        {
+            Napi::TypeError::New(env, "Image path (string) or buffer expected at index " + std::to_string(i)).ThrowAsJavaScriptException();
+            return false;
+        }
+        keep_alive.Set(i, input);
+    }
+
+    return true;
+}
+
+// Optional trailing options object:
+// { compact?: boolean, lineMode?: boolean, timeout?: number (ms), cancelToken?: CancelToken }
+DetectOptions OCREngineWrapper::ParseOptions(const Napi::CallbackInfo &info, size_t index)
+{
+    DetectOptions options;
+    if (info.Length() <= index || !info[index].IsObject())
+        return options;
+
+    Napi::Object object = info[index].As<Napi::Object>();
+    options.compact = object.Get("compact").ToBoolean();
+    if (object.Get("lineMode").ToBoolean())
+        options.mode = RunMode::kLines;
+
+    Napi::Value cancel_token = object.Get("cancelToken");
+    AddonData *data = info.Env().GetInstanceData<AddonData>();
+    if (cancel_token.IsObject() && cancel_token.As<Napi::Object>().InstanceOf(data->cancel_token_constructor.Value()))
+        options.cancel = CancelTokenWrapper::Unwrap(cancel_token.As<Napi::Object>())->Token();
+
+    // the deadline counts from the call, time spent waiting for a worker included
+    Napi::Value timeout = object.Get("timeout");
+    if (timeout.IsNumber())
+    {
+        if (!options.cancel)
+            options.cancel = std::make_shared<OCR::CancelToken>();
+        options.cancel->SetTimeout(std::chrono::milliseconds(timeout.As<Napi::Number>().Int64Value()));
+    }
+
+    return options;
+}
+
+Napi::Value OCREngineWrapper::RunSync(Napi::Env env, const std::vector<ImageSource> &sources,
+    const DetectOptions &options) const
+{
+    std::string error;
+    std::vector<cv::Mat> images;
 
-    if (image.empty())
+    if (!LoadImages(sources, images, error))
     {
-        Napi::Error::New(env, "Failed to decode image buffer").ThrowAsJavaScriptException();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    auto results = engine_->Run(image);
+    std::vector<std::vector<OCR::OCRResult>> results;
+    {
+        // sync calls never wait, they only hold async runs back while they run
+        OCR::ModelPool::RunSlot slot;
+        results = RunEngine(*engine_, images, options);
+    }
+
+    return ResultsToValue(env, results, options);
+}
+
+Napi::Value OCREngineWrapper::RunAsync(Napi::Env env, std::vector<ImageSource> sources, Napi::Value keep_alive,
+    const DetectOptions &options) const
+{
+    // the worker deletes itself once the promise is settled
+    DetectWorker *worker = new DetectWorker(env, engine_, std::move(sources), keep_alive, options);
+    Napi::Promise promise = worker->Promise();
+    QueueAdmitted(env, worker);
+
+    return promise;
+}
 
+Napi::Array OCREngineWrapper::ResultsToArray(Napi::Env env, const std::vector<OCR::OCRResult> &results)
+{
     Napi::Array result_array = Napi::Array::New(env, results.size());
     for (size_t i = 0; i < results.size(); ++i)
     {
@@ -123,6 +914,141 @@ Napi::Value OCREngineWrapper::DetectBuffer(const Napi::CallbackInfo &info)
     return result_array;
 }
 
+Napi::Value OCREngineWrapper::ResultsToValue(Napi::Env env, const std::vector<std::vector<OCR::OCRResult>> &results,
+    const DetectOptions &options)
+{
+    const bool partial = IsPartial(options);
+    auto to_value = [&](const std::vector<OCR::OCRResult> &image_results) -> Napi::Value
+    {
+        Napi::Object value = options.compact ? ResultsToCompact(env, image_results) :
+            options.mode == RunMode::kBoxes ? BoxesToArray(env, image_results) : ResultsToArray(env, image_results);
+        if (partial)
+            value.Set("partial", Napi::Boolean::New(env, true));
+        return value;
+    };
+
+    if (!options.batch)
+    {
+        if (results.size() == 1)
+            return to_value(results.front());
+
+        // recognize(): the single lines of all inputs in one list
+        std::vector<OCR::OCRResult> flat_results;
+        for (const auto &image_results : results)
+            flat_results.insert(flat_results.end(), image_results.begin(), image_results.end());
+        return to_value(flat_results);
+    }
+
+    Napi::Array batch_array = Napi::Array::New(env, results.size());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        batch_array.Set(i, to_value(results[i]));
+    }
+
+    return batch_array;
+}
+
+// Whether the run stopped early, its results only hold the lines recognized until then.
+bool OCREngineWrapper::IsPartial(const DetectOptions &options)
+{
+    return options.cancel && options.cancel->Interrupted();
+}
+
+// Columnar encoding of the results: line i owns boxes[8i, 8i + 8) as x0, y0 ... x3, y3,
+// charScores[charOffsets[i], charOffsets[i + 1]) and the UTF-8 bytes
+// text[textOffsets[i], textOffsets[i + 1]).
+Napi::Object OCREngineWrapper::ResultsToCompact(Napi::Env env, const std::vector<OCR::OCRResult> &results)
+{
+    const size_t count = results.size();
+
+    size_t total_chars = 0, total_bytes = 0;
+    for (const auto &result : results)
+    {
+        total_chars += result.line.scores.size();
+        total_bytes += result.line.text.size();
+    }
+
+    Napi::Int32Array boxes = Napi::Int32Array::New(env, count * 8);
+    Napi::Float32Array box_scores = Napi::Float32Array::New(env, count);
+    Napi::Float32Array angle_scores = Napi::Float32Array::New(env, count);
+    Napi::Uint8Array rotated = Napi::Uint8Array::New(env, count);
+    Napi::Float32Array char_scores = Napi::Float32Array::New(env, total_chars);
+    Napi::Uint32Array char_offsets = Napi::Uint32Array::New(env, count + 1);
+    Napi::Buffer<char> text = Napi::Buffer<char>::New(env, total_bytes);
+    Napi::Uint32Array text_offsets = Napi::Uint32Array::New(env, count + 1);
+
+    int32_t *box_data = boxes.Data();
+    float *char_data = char_scores.Data();
+    char *text_data = text.Data();
+    size_t char_pos = 0, text_pos = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const OCR::OCRResult &result = results[i];
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            const cv::Point pt = j < result.box.points.size() ? result.box.points[j] : cv::Point{};
+            box_data[i * 8 + j * 2] = pt.x;
+            box_data[i * 8 + j * 2 + 1] = pt.y;
+        }
+        box_scores[i] = result.box.score;
+        angle_scores[i] = result.angle.score;
+        rotated[i] = result.angle.is_rot ? 1 : 0;
+
+        char_offsets[i] = static_cast<uint32_t>(char_pos);
+        std::copy(result.line.scores.begin(), result.line.scores.end(), char_data + char_pos);
+        char_pos += result.line.scores.size();
+
+        text_offsets[i] = static_cast<uint32_t>(text_pos);
+        std::copy(result.line.text.begin(), result.line.text.end(), text_data + text_pos);
+        text_pos += result.line.text.size();
+    }
+    char_offsets[count] = static_cast<uint32_t>(char_pos);
+    text_offsets[count] = static_cast<uint32_t>(text_pos);
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("count", Napi::Number::New(env, static_cast<double>(count)));
+    obj.Set("boxes", boxes);
+    obj.Set("boxScores", box_scores);
+    obj.Set("angleScores", angle_scores);
+    obj.Set("rotated", rotated);
+    obj.Set("charScores", char_scores);
+    obj.Set("charOffsets", char_offsets);
+    obj.Set("text", text);
+    obj.Set("textOffsets", text_offsets);
+
+    return obj;
+}
+
+Napi::Array OCREngineWrapper::BoxesToArray(Napi::Env env, const std::vector<OCR::OCRResult> &results)
+{
+    Napi::Array box_array = Napi::Array::New(env, results.size());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("box", BoxToArray(env, results[i].box));
+        obj.Set("boxScore", Napi::Number::New(env, results[i].box.score));
+        box_array.Set(i, obj);
+    }
+
+    return box_array;
+}
+
+Napi::Array OCREngineWrapper::BoxToArray(Napi::Env env, const OCR::TextBox &box)
+{
+    Napi::Array points = Napi::Array::New(env, box.points.size());
+    for (size_t i = 0; i < box.points.size(); ++i)
+    {
+        Napi::Object point = Napi::Object::New(env);
+        point.Set("x", Napi::Number::New(env, box.points[i].x));
+        point.Set("y", Napi::Number::New(env, box.points[i].y));
+        points.Set(i, point);
+    }
+
+    return points;
+}
+
 Napi::Object OCREngineWrapper::ResultToObject(Napi::Env env, const OCR::OCRResult &result)
 {
     Napi::Object obj = Napi::Object::New(env);
@@ -139,15 +1065,7 @@ Napi::Object OCREngineWrapper::ResultToObject(Napi::Env env, const OCR::OCRResul
     obj.Set("charScores", scores);
 
     // Bounding box points
-    Napi::Array box = Napi::Array::New(env, result.box.points.size());
-    for (size_t i = 0; i < result.box.points.size(); ++i)
-    {
-        Napi::Object point = Napi::Object::New(env);
-        point.Set("x", Napi::Number::New(env, result.box.points[i].x));
-        point.Set("y", Napi::Number::New(env, result.box.points[i].y));
-        box.Set(i, point);
-    }
-    obj.Set("box", box);
+    obj.Set("box", BoxToArray(env, result.box));
     obj.Set("boxScore", Napi::Number::New(env, result.box.score));
 
     // Angle info
@@ -159,9 +1077,33 @@ Napi::Object OCREngineWrapper::ResultToObject(Napi::Env env, const OCR::OCRResul
     return obj;
 }
 
+// Process-wide limit of concurrently running detections, shared by all
+// engines and worker_threads; <= 0 means unlimited
+static Napi::Value SetMaxConcurrency(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Max concurrency (number) expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    OCR::ModelPool::Instance().SetMaxConcurrency(info[0].As<Napi::Number>().Int32Value());
+
+    return env.Undefined();
+}
+
+static Napi::Value GetMaxConcurrency(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), OCR::ModelPool::Instance().GetMaxConcurrency());
+}
+
 // Module initialization
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
+    exports.Set("setMaxConcurrency", Napi::Function::New(env, SetMaxConcurrency, "setMaxConcurrency"));
+    exports.Set("getMaxConcurrency", Napi::Function::New(env, GetMaxConcurrency, "getMaxConcurrency"));
     return OCREngineWrapper::Init(env, exports);
 }
 
@@ -0,0 +1,116 @@
+#ifndef BOUNDED_QUEUE_H_
+#define BOUNDED_QUEUE_H_
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <cstddef>
+#include <condition_variable>
+
+namespace OCR
+{
+
+// depth seen by the producers of a BoundedQueue, sampled on every push
+struct QueueStats
+{
+    size_t capacity{0};
+    size_t max_depth{0};
+    size_t pushes{0};
+    size_t depth_sum{0};
+    size_t full_waits{0};   // pushes that blocked because the queue was full
+
+    double MeanDepth() const
+    {
+        return pushes == 0 ? 0.0 : static_cast<double>(depth_sum) / pushes;
+    }
+
+    void Merge(const QueueStats &other)
+    {
+        capacity = other.capacity;
+        max_depth = std::max(max_depth, other.max_depth);
+        pushes += other.pushes;
+        depth_sum += other.depth_sum;
+        full_waits += other.full_waits;
+    }
+};
+
+// Multi-producer multi-consumer FIFO holding at most capacity items. Push
+// blocks while the queue is full, Pop blocks while it is empty and returns
+// false once the queue is closed and drained.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(const size_t capacity)
+        : capacity_(capacity < 1 ? 1 : capacity)
+    {
+        stats_.capacity = capacity_;
+    }
+
+    // disable copy
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue & operator = (const BoundedQueue &) = delete;
+
+    void Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (items_.size() >= capacity_)
+        {
+            ++stats_.full_waits;
+            not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+        }
+        items_.emplace_back(std::move(item));
+
+        ++stats_.pushes;
+        stats_.depth_sum += items_.size();
+        stats_.max_depth = std::max(stats_.max_depth, items_.size());
+
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+
+    bool Pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty())
+            return false;
+
+        item = std::move(items_.front());
+        items_.pop_front();
+
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // no more pushes, wakes up every waiting consumer
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+    }
+
+    QueueStats Stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> items_;
+    bool closed_{false};
+    QueueStats stats_{};
+};
+
+}   // namespace OCR
+
+#endif  // BOUNDED_QUEUE_H_
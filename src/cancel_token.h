@@ -0,0 +1,75 @@
+#ifndef CANCEL_TOKEN_H_
+#define CANCEL_TOKEN_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace OCR
+{
+
+// Cancellation flag plus optional deadline of an OCR run. The engine polls
+// Expired() between stages and between text lines and returns the lines
+// recognized so far once it is true; Interrupted() then reports that the
+// results are partial.
+class CancelToken
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CancelToken() = default;
+
+    // disable copy
+    CancelToken(const CancelToken &) = delete;
+    CancelToken & operator = (const CancelToken &) = delete;
+
+    // may be called from any thread
+    void Cancel()
+    {
+        cancelled_.store(true, std::memory_order_relaxed);
+    }
+
+    void SetDeadline(const Clock::time_point deadline)
+    {
+        deadline_.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void SetTimeout(const std::chrono::milliseconds timeout)
+    {
+        SetDeadline(Clock::now() + timeout);
+    }
+
+    // true once cancelled or past the deadline; only call it where work would
+    // be skipped, a true result marks the run as interrupted
+    bool Expired() const
+    {
+        if (interrupted_.load(std::memory_order_relaxed))
+            return true;
+
+        const Clock::rep deadline = deadline_.load(std::memory_order_relaxed);
+        if (cancelled_.load(std::memory_order_relaxed) ||
+            (deadline != kNoDeadline && Clock::now().time_since_epoch().count() >= deadline))
+        {
+            interrupted_.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // whether a run using this token stopped early
+    bool Interrupted() const
+    {
+        return interrupted_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr Clock::rep kNoDeadline = 0;
+
+    std::atomic<bool> cancelled_{false};
+    std::atomic<Clock::rep> deadline_{kNoDeadline};
+    mutable std::atomic<bool> interrupted_{false};
+};
+
+}   // namespace OCR
+
+#endif  // CANCEL_TOKEN_H_
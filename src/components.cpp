@@ -0,0 +1,293 @@
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "components.h"
+
+namespace OCR
+{
+
+namespace
+{
+
+// runs are union-find nodes linked to a smaller index only, so the root of a
+// component is its first run in raster order
+int FindRoot(int *parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void Union(int *parent, int a, int b)
+{
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+// one row of same colored pixels, rows are tiled by alternating runs
+struct Run
+{
+    int x0;
+    int x1;
+    bool is_fg;
+};
+
+// runs of rows [y0, y1), labeled without looking above y0
+struct Strip
+{
+    int y0{0};
+    int y1{0};
+    std::vector<Run> runs;
+    std::vector<int> row_begin;     // runs of row y0 + r are [row_begin[r], row_begin[r + 1])
+    std::vector<int> parent;        // union-find over runs, global after the seams are joined
+    int offset{0};                  // index of the first run over all strips
+};
+
+void AppendRuns(const uint8_t *row, const int cols, std::vector<Run> &runs)
+{
+    // bitmaps are 0 or 255, so whole words of one color are skipped at once
+    for (int x0 = 0, x = 0; x0 < cols; x0 = x)
+    {
+        const bool is_fg = row[x0] != 0;
+        const uint64_t fill = is_fg ? UINT64_MAX : 0;
+        uint64_t word;
+        for (; x + 8 <= cols; x += 8)
+        {
+            std::memcpy(&word, row + x, sizeof(word));
+            if (word != fill)
+                break;
+        }
+        while (x < cols && (row[x] != 0) == is_fg)
+            ++x;
+        runs.push_back(Run{x0, x - 1, is_fg});
+    }
+}
+
+// joins the runs of a row with the runs above it, foreground 8-connected and
+// background 4-connected like the border follower; run k is node base + k
+void LinkRows(const Run *up, const int num_up, const int up_base,
+    const Run *cur, const int num_cur, const int cur_base, int *parent)
+{
+    int first = 0;
+    for (int c = 0; c < num_cur; ++c)
+    {
+        const int reach = cur[c].is_fg ? 1 : 0;
+        while (first < num_up && up[first].x1 < cur[c].x0 - 1)
+            ++first;
+        for (int u = first; u < num_up && up[u].x0 <= cur[c].x1 + reach; ++u)
+        {
+            if (up[u].is_fg == cur[c].is_fg && up[u].x1 >= cur[c].x0 - reach)
+                Union(parent, cur_base + c, up_base + u);
+        }
+    }
+}
+
+void LabelStrip(const cv::Mat &bitmap, Strip &strip)
+{
+    strip.row_begin.assign(1, 0);
+    for (int y = strip.y0; y < strip.y1; ++y)
+    {
+        AppendRuns(bitmap.ptr<uint8_t>(y), bitmap.cols, strip.runs);
+        strip.row_begin.push_back(static_cast<int>(strip.runs.size()));
+    }
+
+    strip.parent.resize(strip.runs.size());
+    for (size_t k = 0; k < strip.parent.size(); ++k)
+        strip.parent[k] = static_cast<int>(k);
+    for (size_t r = 1; r + 1 < strip.row_begin.size(); ++r)
+    {
+        const int up = strip.row_begin[r - 1], cur = strip.row_begin[r];
+        LinkRows(strip.runs.data() + up, cur - up, up,
+            strip.runs.data() + cur, strip.row_begin[r + 1] - cur, cur, strip.parent.data());
+    }
+}
+
+struct Component
+{
+    bool is_fg{false};
+    bool is_outside{false};     // background reaching the image border
+    int top{0};
+    std::vector<int> lo, hi;    // row extremes from top down
+};
+
+// row extremes from the top left pixel down the left side and up the right side,
+// counter-clockwise on screen like an outer border
+void OuterPoints(const Component &component, std::vector<cv::Point> &points)
+{
+    const int rows = static_cast<int>(component.lo.size());
+    points.reserve(2 * rows);
+    for (int r = 0; r < rows; ++r)
+        points.emplace_back(component.lo[r], component.top + r);
+    for (int r = rows - 1; r >= 0; --r)
+        points.emplace_back(component.hi[r], component.top + r);
+}
+
+// extremes of the foreground pixels 4-adjacent to the hole, from the pixel left
+// of its top left pixel over the top and down the right side, clockwise on screen
+// like a hole border
+void HolePoints(const Component &component, std::vector<cv::Point> &points)
+{
+    const int rows = static_cast<int>(component.lo.size());
+    std::vector<int> lo(rows + 2, INT32_MAX), hi(rows + 2, INT32_MIN);
+    for (int r = 0; r < rows; ++r)
+    {
+        // border row r + 1 is hole row r, between border rows r and r + 2
+        lo[r + 1] = std::min(lo[r + 1], component.lo[r] - 1);
+        hi[r + 1] = std::max(hi[r + 1], component.hi[r] + 1);
+        for (int b : {r, r + 2})
+        {
+            lo[b] = std::min(lo[b], component.lo[r]);
+            hi[b] = std::max(hi[b], component.hi[r]);
+        }
+    }
+
+    const int top = component.top - 1;
+    points.reserve(2 * rows + 5);
+    points.emplace_back(component.lo[0] - 1, component.top);
+    points.emplace_back(lo[0], top);
+    for (int b = 0; b < rows + 2; ++b)
+        points.emplace_back(hi[b], top + b);
+    for (int b = rows + 1; b >= 1; --b)
+        points.emplace_back(lo[b], top + b);
+}
+
+}   // namespace
+
+std::vector<std::vector<cv::Point>> FindComponentContours(const cv::Mat &bitmap, ThreadPool &pool,
+    const size_t max_contours)
+{
+    const int rows = bitmap.rows, cols = bitmap.cols;
+    if (rows == 0 || cols == 0)
+        return {};
+
+    // strips of at least 32 rows, one per core
+    const int num_strips = std::max(1, std::min(pool.Size(), rows / 32));
+    std::vector<Strip> strips(num_strips);
+    std::vector<size_t> strip_order(num_strips);
+    for (int s = 0; s < num_strips; ++s)
+    {
+        strips[s].y0 = static_cast<int>(static_cast<int64_t>(rows) * s / num_strips);
+        strips[s].y1 = static_cast<int>(static_cast<int64_t>(rows) * (s + 1) / num_strips);
+        strip_order[s] = s;
+    }
+
+    // label strips on their own, then join the seams
+    pool.ParallelFor(strip_order, [&](size_t s)
+    {
+        LabelStrip(bitmap, strips[s]);
+    });
+
+    int num_runs = 0;
+    for (auto &strip : strips)
+    {
+        strip.offset = num_runs;
+        num_runs += static_cast<int>(strip.runs.size());
+    }
+
+    std::vector<int> parent(num_runs), label(num_runs);
+    pool.ParallelFor(strip_order, [&](size_t s)
+    {
+        for (size_t k = 0; k < strips[s].parent.size(); ++k)
+            parent[strips[s].offset + k] = strips[s].offset + strips[s].parent[k];
+    });
+    for (int s = 1; s < num_strips; ++s)
+    {
+        const Strip &above = strips[s - 1], &below = strips[s];
+        const int up = above.row_begin[above.row_begin.size() - 2];
+        const int num_up = static_cast<int>(above.runs.size()) - up;
+        LinkRows(above.runs.data() + up, num_up, above.offset + up,
+            below.runs.data(), below.row_begin[1], below.offset, parent.data());
+    }
+
+    // resolve roots without writing to parent, other strips read it meanwhile
+    std::vector<int> num_roots(num_strips, 0);
+    pool.ParallelFor(strip_order, [&](size_t s)
+    {
+        for (int i = strips[s].offset, end = i + static_cast<int>(strips[s].runs.size()); i < end; ++i)
+        {
+            int root = parent[i];
+            while (parent[root] != root)
+                root = parent[root];
+            label[i] = root;
+            num_roots[s] += root == i;
+        }
+    });
+
+    // component ids in order of their first pixel, stored at the root in parent
+    int num_components = 0;
+    for (int s = 0; s < num_strips; ++s)
+    {
+        int id = num_components;
+        for (int i = strips[s].offset, end = i + static_cast<int>(strips[s].runs.size()); i < end; ++i)
+        {
+            if (label[i] == i)
+                parent[i] = id++;
+        }
+        num_components += num_roots[s];
+    }
+
+    // foreground components and holes, i.e. background not reaching the border
+    std::vector<Component> components(num_components);
+    for (const auto &strip : strips)
+    {
+        for (int y = strip.y0; y < strip.y1; ++y)
+        {
+            const int r = y - strip.y0;
+            for (int k = strip.row_begin[r]; k < strip.row_begin[r + 1]; ++k)
+            {
+                const Run &run = strip.runs[k];
+                Component &component = components[parent[label[strip.offset + k]]];
+                if (component.lo.empty())
+                {
+                    component.is_fg = run.is_fg;
+                    component.top = y;
+                }
+                if (!run.is_fg && (y == 0 || y == rows - 1 || run.x0 == 0 || run.x1 == cols - 1))
+                    component.is_outside = true;
+
+                // runs come in raster order, a new row starts with its leftmost run
+                if (component.top + static_cast<int>(component.lo.size()) == y)
+                {
+                    component.lo.push_back(run.x0);
+                    component.hi.push_back(run.x1);
+                }
+                else
+                    component.hi.back() = run.x1;
+            }
+        }
+    }
+
+    // the border follower meets them in order of their first pixel and
+    // findContours lists them last found first
+    std::vector<size_t> selected;
+    for (int id = num_components - 1; id >= 0 && selected.size() < max_contours; --id)
+    {
+        if (components[id].is_fg || !components[id].is_outside)
+            selected.push_back(id);
+    }
+
+    std::vector<std::vector<cv::Point>> contours(selected.size());
+    std::vector<size_t> order(selected.size());
+    for (size_t k = 0; k < order.size(); ++k)
+        order[k] = k;
+    pool.ParallelFor(order, [&](size_t k)
+    {
+        const Component &component = components[selected[k]];
+        if (component.is_fg)
+            OuterPoints(component, contours[k]);
+        else
+            HolePoints(component, contours[k]);
+    });
+
+    return contours;
+}
+
+}   // namespace OCR
@@ -0,0 +1,25 @@
+#ifndef COMPONENTS_H_
+#define COMPONENTS_H_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "thread_pool.h"
+
+namespace OCR
+{
+
+// Drop-in for cv::findContours(bitmap, RETR_LIST, CHAIN_APPROX_SIMPLE) when only the
+// min area rect of each contour is needed. The bitmap is labeled in row strips on
+// pool, foreground 8-connected and background 4-connected like Suzuki's border
+// following, then every component and every hole becomes one point sequence:
+// its row extremes, starting where the border follower starts and running in
+// its direction. These have the same convex hull, in the same order, as the
+// traced contours, so cv::minAreaRect gives the same rects. Contours come in
+// findContours order and only the first max_contours are built.
+std::vector<std::vector<cv::Point>> FindComponentContours(const cv::Mat &bitmap, ThreadPool &pool,
+    const size_t max_contours);
+
+}   // namespace OCR
+
+#endif  // COMPONENTS_H_
@@ -16,33 +16,60 @@ struct DetConfig
     float bitmap_thres{0.3f};
     float unclip_ratio{2.0f};
     bool is_fp16{false};
+    bool use_ccl{false};        // connected component labeling instead of findContours
 };
 
 struct ClsConfig
 {
     int infer_threads{1};
-    int reco_threads{1};
     std::string model_path;
     bool enable{true};
     bool most_angle{true};
     bool is_fp16{false};
+    int batch_size{8};      // lines per pool task, run on one extractor
+    int vote_lines{0};      // most_angle stops after this many agreeing confident lines, 0 classifies all
+    float vote_thres{0.9f}; // score of a confident line
 };
 
 struct RecConfig
 {
     int infer_threads{1};
-    int reco_threads{1};
     std::string model_path;
     std::string keys_path;
     bool is_fp16{false};
+    int batch_size{8};      // lines per pool task, run on one set of pooled allocators
+};
+
+// orientation pre-pass ahead of detection: a low resolution det tells vertical
+// from horizontal text and sampled cls crops tell upright from upside down
+struct PageConfig
+{
+    bool enable{false};
+    int max_side_len{512};      // of the pre-pass detection
+    int sample_lines{8};        // most confident boxes that are classified
+    float score_thres{0.9f};    // pages at least this certain are rotated and skip per-line cls
+};
+
+// runs det, cls and rec of different images at the same time, each stage with
+// its own workers; the lines of every worker share the engine's thread pool
+struct PipelineConfig
+{
+    bool enable{false};
+    int det_workers{1};
+    int cls_workers{1};
+    int rec_workers{1};
+    int queue_size{2};      // images waiting between two stages
 };
 
 struct Config
 {
     bool is_save{false};
+    int threads{1};         // core budget of the engine's thread pool
     DetConfig det_config{};
     ClsConfig cls_config{};
     RecConfig rec_config{};
+    PipelineConfig pipeline_config{};
+    PageConfig page_config{};
 };
 
 }   // namespace OCR
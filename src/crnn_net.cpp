@@ -5,6 +5,8 @@
 
 #include "plog/Log.h"
 
+#include "model_pool.h"
+#include "simd.h"
 #include "crnn_net.h"
 #include "utils.h"
 
@@ -19,6 +21,7 @@ CRNNNet::CRNNNet(const RecConfig &config)
 CRNNNet::CRNNNet(CRNNNet &&other) noexcept
     : config_(std::exchange(other.config_, {}))
     , net_(std::move(other.net_))
+    , pool_(std::move(other.pool_))
     , keys_(std::move(other.keys_))
 {
 
@@ -30,29 +33,21 @@ CRNNNet & CRNNNet::operator = (CRNNNet &&other) noexcept
     {
         config_ = std::exchange(other.config_, {});
         net_ = std::move(other.net_);
+        pool_ = std::move(other.pool_);
         keys_ = std::move(other.keys_);
     }
     return *this;
 }
 
-bool CRNNNet::Initialize(const RecConfig &config)
+bool CRNNNet::Initialize(const RecConfig &config, std::shared_ptr<ThreadPool> pool)
 {
     config_ = config;
+    pool_ = pool ? std::move(pool) : std::make_shared<ThreadPool>(1);
 
-    // create net
-    net_ = std::make_unique<ncnn::Net>();
-    net_->opt.num_threads = config_.infer_threads;
-    net_->opt.use_fp16_packed = config_.is_fp16;
-    net_->opt.use_fp16_storage = config_.is_fp16;
-    net_->opt.use_fp16_arithmetic = config_.is_fp16;
-
-    if (net_->load_param((config_.model_path + ".param").c_str()) ||
-        net_->load_model((config_.model_path + ".bin").c_str()))
-    {
-        PLOGE << "Failed to load model " << config_.model_path;
-        net_.reset();
+    // get net, shared with other engines using the same model
+    net_ = ModelPool::Instance().GetNet(config_.model_path, config_.is_fp16);
+    if (!net_)
         return false;
-    }
 
     // load keys
     std::string line;
@@ -70,61 +65,108 @@ bool CRNNNet::Initialize(const RecConfig &config)
     return true;
 }
 
-std::vector<TextLine> CRNNNet::Rec(const std::vector<cv::Mat> &text_images) const
+std::vector<TextLine> CRNNNet::Rec(const std::vector<cv::Mat> &text_images, const LineCallback &on_line,
+    const CancelToken *cancel) const
 {
     std::vector<TextLine> text_lines(text_images.size());
 
-    #pragma omp parallel for num_threads(config_.reco_threads) schedule(dynamic)
-    for (size_t i = 0; i < text_lines.size(); ++i)
+    // longest lines first so no long line is left for the end; smaller batches
+    // while there are fewer lines than batch_size per core
+    const std::vector<size_t> order = GetLongestFirstOrder(text_images);
+    const size_t per_core = (order.size() + pool_->Size() - 1) / pool_->Size();
+    const size_t batch_size = std::max<size_t>(1, std::min<size_t>(config_.batch_size, per_core));
+    std::vector<size_t> batches((order.size() + batch_size - 1) / batch_size);
+    for (size_t b = 0; b < batches.size(); ++b)
+        batches[b] = b;
+
+    // cores not needed for batches go to ncnn
+    const int infer_threads = std::min(config_.infer_threads, pool_->ThreadsPerTask(batches.size()));
+    pool_->ParallelFor(batches, [&](size_t b)
     {
-        text_lines[i] = Rec(text_images[i]);
-    }
+        RecBatch(text_images, order, b * batch_size, std::min(order.size(), (b + 1) * batch_size),
+            infer_threads, text_lines, on_line, cancel);
+    });
 
     return text_lines;
 }
 
-TextLine CRNNNet::Rec(const cv::Mat &text_image) const
+void CRNNNet::RecBatch(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &order,
+    const size_t begin, const size_t end, const int infer_threads, std::vector<TextLine> &text_lines,
+    const LineCallback &on_line, const CancelToken *cancel) const
+{
+    // ncnn has no batch axis: the lines of a batch run one after another, each at
+    // its own width, on pooled allocators that hand the buffers of the previous
+    // line to the next; the batch is a run of the longest-first order, so widths
+    // are close. Blobs are only allocated on this thread, workspace also on ncnn's
+    // threads with infer_threads > 1
+    ncnn::UnlockedPoolAllocator blob_allocator;
+    ncnn::PoolAllocator workspace_allocator;
+
+    for (size_t j = begin; j < end; ++j)
+    {
+        if (cancel && cancel->Expired())
+            return;
+
+        const size_t i = order[j];
+        const cv::Mat &text_image = text_images[i];
+        ncnn::Mat blob = LineBlob(text_image, ResizedWidth(text_image), &blob_allocator);
+
+        // inference
+        ncnn::Extractor ex = net_->create_extractor();
+        ex.set_num_threads(infer_threads);
+        ex.set_blob_allocator(&blob_allocator);
+        ex.set_workspace_allocator(&workspace_allocator);
+        ex.input("input", blob);
+        ncnn::Mat out;
+        ex.extract("output", out);
+
+        // decode output and get TextLine
+        text_lines[i] = Score2TextLine(out, out.h);
+        if (on_line)
+            on_line(i, text_lines[i]);
+    }
+}
+
+int CRNNNet::ResizedWidth(const cv::Mat &text_image) const
 {
-    // resize
     float ratio = static_cast<float>(target_h_) / text_image.rows;
-    int rsz_w = text_image.cols * ratio;
+    return std::max(1, static_cast<int>(text_image.cols * ratio));
+}
 
-    ncnn::Mat blob = ncnn::Mat::from_pixels_resize(text_image.data, ncnn::Mat::PIXEL_RGB,
-        text_image.cols, text_image.rows, rsz_w, target_h_);
+ncnn::Mat CRNNNet::LineBlob(const cv::Mat &text_image, const int rsz_w, ncnn::Allocator *allocator) const
+{
+    const int stride = static_cast<int>(text_image.step);
+    ncnn::Mat blob = text_image.rows == target_h_ && text_image.cols == rsz_w ?
+        ncnn::Mat::from_pixels(text_image.data, ncnn::Mat::PIXEL_RGB, rsz_w, target_h_, stride, allocator) :
+        ncnn::Mat::from_pixels_resize(text_image.data, ncnn::Mat::PIXEL_RGB,
+            text_image.cols, text_image.rows, stride, rsz_w, target_h_, allocator);
     blob.substract_mean_normalize(mean_values_, norm_values_);
 
-    // inference
-    ncnn::Extractor ex = net_->create_extractor();
-    ex.input("input", blob);
-    ncnn::Mat out;
-    ex.extract("output", out);
-
-    // decode output and get TextLine
-    float *arr = reinterpret_cast<float *>(out.data);
-    std::vector<float> scores(arr, arr + out.h * out.w);
-
-    return Score2TextLine(scores, out.h, out.w);
+    return blob;
 }
 
-TextLine CRNNNet::Score2TextLine(const std::vector<float> &scores, const int rows, const int cols) const
+TextLine CRNNNet::Score2TextLine(const ncnn::Mat &out, const int rows) const
 {
+    const int cols = out.w;
     if (cols != static_cast<int>(keys_.size()))
     {
         PLOGE << "Unmatched scores: " << cols << " != " << keys_.size();
         return TextLine{};
     }
 
+    // keys are single characters, at most 4 bytes in UTF-8
     std::string text;
     std::vector<float> text_scores;
+    text.reserve(static_cast<size_t>(rows) * 4);
+    text_scores.reserve(rows);
     int prev_i = -1;
     const int blank_i = 0;
 
+    // rows are read in place from the output
     for (int i = 0; i < rows; ++i)
     {
-        auto max_it = std::max_element(scores.begin() + i * cols, scores.begin() + (i + 1) * cols);
-        int max_i = std::distance(scores.begin(), max_it);
-        max_i %= cols;
-        float max_v = *max_it;
+        float max_v;
+        const int max_i = ArgMax(out.row(i), cols, max_v);
 
         if (max_i != blank_i && max_i != prev_i)
         {
@@ -139,4 +181,4 @@ TextLine CRNNNet::Score2TextLine(const std::vector<float> &scores, const int row
     return {text, text_scores};
 }
 
-}   // namespace OCR
\ No newline at end of file
+}   // namespace OCR
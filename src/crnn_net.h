@@ -4,12 +4,15 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <functional>
 
 #include <net.h>
 #include <opencv2/opencv.hpp>
 
 #include "common.h"
 #include "config.h"
+#include "cancel_token.h"
+#include "thread_pool.h"
 
 namespace OCR
 {
@@ -29,22 +32,41 @@ public:
     CRNNNet(const CRNNNet &) = delete;
     CRNNNet & operator = (const CRNNNet &) = delete;
 
-    bool Initialize(const RecConfig &config);
+    // lines run on pool, a single-threaded pool is used without one
+    bool Initialize(const RecConfig &config, std::shared_ptr<ThreadPool> pool = nullptr);
 
-    std::vector<TextLine> Rec(const std::vector<cv::Mat> &text_images) const;
+    // called with (index, line) as soon as a line is recognized, possibly from several threads at once
+    using LineCallback = std::function<void(size_t, const TextLine &)>;
+
+    // once cancel expires the remaining lines are skipped, on_line tells which lines were recognized
+    std::vector<TextLine> Rec(const std::vector<cv::Mat> &text_images, const LineCallback &on_line = nullptr,
+        const CancelToken *cancel = nullptr) const;
+
+    // input height, lines already this high are only normalized
+    static int TargetHeight() { return target_h_; }
 
 private:
     RecConfig config_{};
-    std::unique_ptr<ncnn::Net> net_{};
+    std::shared_ptr<const ncnn::Net> net_{};
+    std::shared_ptr<ThreadPool> pool_{};
     std::vector<std::string> keys_{};
 
     static inline const int target_h_ = 48;
     static inline const float mean_values_[3]{127.5f, 127.5f, 127.5f};
     static inline const float norm_values_[3]{1.0f / 127.5f, 1.0f / 127.5f, 1.0f / 127.5f};
 
-    TextLine Rec(const cv::Mat &text_image) const;
+    // recognizes text_images[order[begin, end)] on one set of pooled allocators
+    void RecBatch(const std::vector<cv::Mat> &text_images, const std::vector<size_t> &order,
+        const size_t begin, const size_t end, const int infer_threads, std::vector<TextLine> &text_lines,
+        const LineCallback &on_line, const CancelToken *cancel) const;
+
+    int ResizedWidth(const cv::Mat &text_image) const;
+
+    // text_image resized to rsz_w x target_h_ and normalized
+    ncnn::Mat LineBlob(const cv::Mat &text_image, const int rsz_w, ncnn::Allocator *allocator = nullptr) const;
 
-    TextLine Score2TextLine(const std::vector<float> &scores, const int rows, const int cols) const;
+    // greedy CTC decode of the first rows time steps of out
+    TextLine Score2TextLine(const ncnn::Mat &out, const int rows) const;
 };
 
 }   // namespace OCR
@@ -1,8 +1,13 @@
+#include <cmath>
 #include <utility>
+#include <iterator>
 #include <algorithm>
 
 #include "plog/Log.h"
 
+#include "model_pool.h"
+#include "simd.h"
+#include "components.h"
 #include "utils.h"
 #include "db_net.h"
 
@@ -17,6 +22,7 @@ DBNet::DBNet(const DetConfig &config)
 DBNet::DBNet(DBNet &&other) noexcept
     : config_(std::exchange(other.config_, {}))
     , net_(std::move(other.net_))
+    , pool_(std::move(other.pool_))
 {
 
 }
@@ -27,45 +33,37 @@ DBNet & DBNet::operator = (DBNet &&other) noexcept
     {
         config_ = std::exchange(other.config_, {});
         net_ = std::move(other.net_);
+        pool_ = std::move(other.pool_);
     }
     return *this;
 }
 
-bool DBNet::Initialize(const DetConfig &config)
+bool DBNet::Initialize(const DetConfig &config, std::shared_ptr<ThreadPool> pool)
 {
     config_ = config;
+    pool_ = pool ? std::move(pool) : std::make_shared<ThreadPool>(1);
 
-    // create net
-    net_ = std::make_unique<ncnn::Net>();
-    net_->opt.num_threads = config_.infer_threads;
-    net_->opt.use_fp16_packed = config_.is_fp16;
-    net_->opt.use_fp16_storage = config_.is_fp16;
-    net_->opt.use_fp16_arithmetic = config_.is_fp16;
-
-    if (net_->load_param((config_.model_path + ".param").c_str()) ||
-        net_->load_model((config_.model_path + ".bin").c_str()))
-    {
-        PLOGE << "Failed to load model " << config_.model_path;
-        net_.reset();
+    // get net, shared with other engines using the same model
+    net_ = ModelPool::Instance().GetNet(config_.model_path, config_.is_fp16);
+    if (!net_)
         return false;
-    }
 
     return true;
 }
 
 std::vector<TextBox> DBNet::Det(const cv::Mat &image) const
 {
-    // padding
+    return Det(image, config_.max_side_len);
+}
+
+std::vector<TextBox> DBNet::Det(const cv::Mat &image, const int max_side_len) const
+{
+    // sizes of the image with its padding border
     const int padding = config_.padding;
-    cv::Mat pad_image = image.clone();
-    cv::copyMakeBorder(image, pad_image, padding, padding, padding, padding,
-        cv::BORDER_CONSTANT | cv::BORDER_ISOLATED, cv::Scalar(255.0, 255.0, 255.0));
+    int img_rows = image.rows + 2 * padding, img_cols = image.cols + 2 * padding;
+    const int target_size = std::min(max_side_len + 2 * padding, std::max(img_rows, img_cols));
 
     // resize
-    const int target_size = std::min(config_.max_side_len + 2 * padding,
-        std::max(pad_image.rows, pad_image.cols));
-
-    int img_rows = pad_image.rows, img_cols = pad_image.cols;
     float ratio = static_cast<float>(target_size) / std::max(img_rows, img_cols);
     int rsz_rows = std::max(static_cast<int>(img_rows * ratio) / target_stride_ * target_stride_, target_stride_);
     int rsz_cols = std::max(static_cast<int>(img_cols * ratio) / target_stride_ * target_stride_, target_stride_);
@@ -75,78 +73,129 @@ std::vector<TextBox> DBNet::Det(const cv::Mat &image) const
     PLOGD.printf("src_w(%d), src_h(%d), dst_w(%d), dst_h(%d), ratio_w(%f), ratio_h(%f)",
         img_cols, img_rows, rsz_cols, rsz_rows, ratio_cols, ratio_rows);
 
-    ncnn::Mat blob = ncnn::Mat::from_pixels_resize(
-        pad_image.data, ncnn::Mat::PIXEL_RGB, img_cols, img_rows, rsz_cols, rsz_rows);
+    // the padding is virtual: the image is resized straight into the interior of
+    // a white buffer of the blob size, no padded copy of the input is made
+    const int roi_x = static_cast<int>(std::lround(padding * ratio_cols));
+    const int roi_y = static_cast<int>(std::lround(padding * ratio_rows));
+    const cv::Rect roi(roi_x, roi_y,
+        Clamp(static_cast<int>(std::lround((padding + image.cols) * ratio_cols)) - roi_x, 1, rsz_cols - roi_x),
+        Clamp(static_cast<int>(std::lround((padding + image.rows) * ratio_rows)) - roi_y, 1, rsz_rows - roi_y));
+
+    // the buffer belongs to this call and is freed once the blob is made
+    ncnn::Mat blob;
+    {
+        cv::Mat pixels(rsz_rows, rsz_cols, CV_8UC3, cv::Scalar::all(255));
+        ncnn::resize_bilinear_c3(image.data, image.cols, image.rows, static_cast<int>(image.step),
+            pixels.ptr<unsigned char>(roi.y) + roi.x * 3, roi.width, roi.height, static_cast<int>(pixels.step));
+        blob = ncnn::Mat::from_pixels(pixels.data, ncnn::Mat::PIXEL_RGB, rsz_cols, rsz_rows);
+    }
     blob.substract_mean_normalize(mean_values_, norm_values_);
 
     // inference
     ncnn::Extractor ex = net_->create_extractor();
+    ex.set_num_threads(config_.infer_threads);
     ex.input("input", blob);
     ncnn::Mat out;
     ex.extract("output", out);
 
-    // binarization
-    const float denorm_values[1] = {255.0f};
-    out.substract_mean_normalize(0, denorm_values);
-
+    // binarization, one pass over the probabilities gives the 0..255 score map
+    // and the mask of probabilities above bitmap_thres
     cv::Mat pred(out.h, out.w, CV_8UC1);
-    out.to_pixels(pred.data, ncnn::Mat::PIXEL_GRAY);
-    cv::Mat bitmap = pred > config_.bitmap_thres;
+    cv::Mat bitmap(out.h, out.w, CV_8UC1);
+    BinarizeScoreMap(reinterpret_cast<const float *>(out.data), static_cast<size_t>(out.w) * out.h, config_.bitmap_thres,
+        pred.data, bitmap.data);
 
     // get boxes from bitmap
-    auto text_boxes = FindBoxesFromBitmap(pred, bitmap, img_rows, img_cols, ratio_rows, ratio_cols);
+    auto text_boxes = FindBoxesFromBitmap(pred, bitmap, image.size(), roi);
 
     return text_boxes;
 }
 
 std::vector<TextBox> DBNet::FindBoxesFromBitmap(const cv::Mat &pred, const cv::Mat &bitmap,
-    const int img_rows, const int img_cols, const float ratio_rows, const float ratio_cols) const
+    const cv::Size &image_size, const cv::Rect &roi) const
 {
+    // both give contours with the same min area rects in the same order
     std::vector<std::vector<cv::Point>> contours;
-    std::vector<cv::Vec4i> hierarchy;
-    cv::findContours(bitmap, contours, hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+    if (config_.use_ccl)
+        contours = FindComponentContours(bitmap, *pool_, max_candidates_);
+    else
+    {
+        std::vector<cv::Vec4i> hierarchy;
+        cv::findContours(bitmap, contours, hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+    }
     size_t num_contours = std::min(contours.size(), max_candidates_);
 
-    std::vector<TextBox> text_boxes;
-    for (size_t i = 0; i < num_contours; ++i)
+    // contiguous chunks of candidates, a few per core so dense areas balance out;
+    // each chunk fills its own buffer
+    const size_t num_chunks = std::min(num_contours, static_cast<size_t>(pool_->Size()) * 4);
+    std::vector<std::vector<TextBox>> chunk_boxes(num_chunks);
+    std::vector<size_t> chunks(num_chunks);
+    for (size_t c = 0; c < num_chunks; ++c)
+        chunks[c] = c;
+
+    pool_->ParallelFor(chunks, [&](size_t c)
     {
-        if (contours[i].size() <= 2)
-            continue;
+        TextBox text_box;
+        for (size_t i = num_contours * c / num_chunks; i < num_contours * (c + 1) / num_chunks; ++i)
+        {
+            if (CandidateToBox(contours[i], pred, image_size, roi, text_box))
+                chunk_boxes[c].emplace_back(std::move(text_box));
+        }
+    });
+
+    // candidates in reverse order, as the serial loop gave them
+    size_t num_boxes = 0;
+    for (const auto &boxes : chunk_boxes)
+        num_boxes += boxes.size();
 
-        cv::RotatedRect min_area_rect = cv::minAreaRect(contours[i]);
+    std::vector<TextBox> text_boxes;
+    text_boxes.reserve(num_boxes);
+    for (auto chunk = chunk_boxes.rbegin(); chunk != chunk_boxes.rend(); ++chunk)
+        std::move(chunk->rbegin(), chunk->rend(), std::back_inserter(text_boxes));
 
-        int long_side;
-        auto min_boxes = GetMinBoxes(min_area_rect, long_side);
-        if (long_side < min_size_)
-            continue;
+    return text_boxes;
+}
 
-        float box_score = BoxScoreFast(min_boxes, pred);
-        if (box_score < config_.box_thres)
-            continue;
+bool DBNet::CandidateToBox(const std::vector<cv::Point> &contour, const cv::Mat &pred,
+    const cv::Size &image_size, const cv::Rect &roi, TextBox &text_box) const
+{
+    if (contour.size() <= 2)
+        return false;
 
-        // unclip
-        cv::RotatedRect unclip_rect = Unclip(min_boxes, config_.unclip_ratio);
-        if (unclip_rect.size.height <= 1.0f || unclip_rect.size.width <= 1.0f)
-            continue;
+    cv::RotatedRect min_area_rect = cv::minAreaRect(contour);
 
-        min_boxes = GetMinBoxes(unclip_rect, long_side);
-        if (long_side < min_size_ + 2)
-            continue;
+    int long_side;
+    auto min_boxes = GetMinBoxes(min_area_rect, long_side);
+    if (long_side < min_size_)
+        return false;
 
-        std::vector<cv::Point> text_points;
-        for (size_t j = 0; j < min_boxes.size(); ++j)
-        {
-            int x = Clamp(static_cast<int>(min_boxes[j].x / ratio_cols) - config_.padding,
-                0, img_cols - 2 * config_.padding - 1);
-            int y = Clamp(static_cast<int>(min_boxes[j].y / ratio_rows) - config_.padding,
-                0, img_rows - 2 * config_.padding - 1);
-            text_points.emplace_back(cv::Point{x, y});
-        }
-        text_boxes.emplace_back(TextBox{text_points, box_score});
+    float box_score = BoxScoreFast(min_boxes, pred);
+    if (box_score < config_.box_thres)
+        return false;
+
+    // unclip
+    cv::RotatedRect unclip_rect = Unclip(min_boxes, config_.unclip_ratio);
+    if (unclip_rect.size.height <= 1.0f || unclip_rect.size.width <= 1.0f)
+        return false;
+
+    min_boxes = GetMinBoxes(unclip_rect, long_side);
+    if (long_side < min_size_ + 2)
+        return false;
+
+    // back from the image area of the blob to the image
+    const float scale_cols = static_cast<float>(image_size.width) / roi.width;
+    const float scale_rows = static_cast<float>(image_size.height) / roi.height;
+
+    std::vector<cv::Point> text_points;
+    for (size_t j = 0; j < min_boxes.size(); ++j)
+    {
+        int x = Clamp(static_cast<int>((min_boxes[j].x - roi.x) * scale_cols), 0, image_size.width - 1);
+        int y = Clamp(static_cast<int>((min_boxes[j].y - roi.y) * scale_rows), 0, image_size.height - 1);
+        text_points.emplace_back(cv::Point{x, y});
     }
-    std::reverse(text_boxes.begin(), text_boxes.end());
+    text_box = TextBox{text_points, box_score};
 
-    return text_boxes;
+    return true;
 }
 
 }   // namespace OCR
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 #include "common.h"
 #include "config.h"
+#include "thread_pool.h"
 
 namespace OCR
 {
@@ -28,13 +29,18 @@ public:
     DBNet(const DBNet &) = delete;
     DBNet & operator = (const DBNet &) = delete;
 
-    bool Initialize(const DetConfig &config);
+    // post-processing runs on pool, a single-threaded pool is used without one
+    bool Initialize(const DetConfig &config, std::shared_ptr<ThreadPool> pool = nullptr);
 
     std::vector<TextBox> Det(const cv::Mat &image) const;
 
+    // detection at a different max_side_len, e.g. a cheap low resolution pass
+    std::vector<TextBox> Det(const cv::Mat &image, const int max_side_len) const;
+
 private:
     DetConfig config_{};
-    std::unique_ptr<ncnn::Net> net_{};
+    std::shared_ptr<const ncnn::Net> net_{};
+    std::shared_ptr<ThreadPool> pool_{};
 
     static inline const int target_stride_{32};
     static inline const size_t max_candidates_{1000};
@@ -42,8 +48,13 @@ private:
     static inline const float mean_values_[3]{0.485f * 255.0f, 0.456f * 255.0f, 0.406f * 255.0f};
     static inline const float norm_values_[3]{1.0f / 0.229f / 255.0f, 1.0f / 0.224f / 255.0f, 1.0f / 0.225f / 255.0f};
 
+    // roi is where the image of image_size lies in the score map, inside the padding
     std::vector<TextBox> FindBoxesFromBitmap(const cv::Mat &pred, const cv::Mat &bitmap,
-        const int img_rows, const int img_cols, const float ratio_rows, const float ratio_cols) const;
+        const cv::Size &image_size, const cv::Rect &roi) const;
+
+    // min area rect, score and unclip of one contour, false if it is no text box
+    bool CandidateToBox(const std::vector<cv::Point> &contour, const cv::Mat &pred,
+        const cv::Size &image_size, const cv::Rect &roi, TextBox &text_box) const;
 };
 
 }   // namespace OCR
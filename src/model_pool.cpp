@@ -0,0 +1,101 @@
+#include "plog/Log.h"
+
+#include "model_pool.h"
+
+namespace OCR
+{
+
+ModelPool & ModelPool::Instance()
+{
+    static ModelPool pool;
+    return pool;
+}
+
+std::shared_ptr<const ncnn::Net> ModelPool::GetNet(const std::string &model_path, const bool is_fp16)
+{
+    // loading under the lock keeps concurrent engines from loading the same model twice
+    std::lock_guard<std::mutex> lock(nets_mutex_);
+
+    auto &cached = nets_[{model_path, is_fp16}];
+    if (auto net = cached.lock())
+    {
+        PLOGD << "Share loaded model " << model_path;
+        return net;
+    }
+
+    auto net = std::make_shared<ncnn::Net>();
+    net->opt.use_fp16_packed = is_fp16;
+    net->opt.use_fp16_storage = is_fp16;
+    net->opt.use_fp16_arithmetic = is_fp16;
+
+    if (net->load_param((model_path + ".param").c_str()) ||
+        net->load_model((model_path + ".bin").c_str()))
+    {
+        PLOGE << "Failed to load model " << model_path;
+        return nullptr;
+    }
+
+    cached = net;
+    return net;
+}
+
+void ModelPool::SetMaxConcurrency(const int max_concurrency)
+{
+    std::unique_lock<std::mutex> lock(slots_mutex_);
+    max_concurrency_ = max_concurrency;
+    AdmitWaiting(lock);
+}
+
+int ModelPool::GetMaxConcurrency() const
+{
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    return max_concurrency_;
+}
+
+bool ModelPool::TryAcquireSlot(std::function<void()> on_free)
+{
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    if (waiting_.empty() && (max_concurrency_ <= 0 || running_ < max_concurrency_))
+    {
+        ++running_;
+        return true;
+    }
+    waiting_.push_back(std::move(on_free));
+    return false;
+}
+
+void ModelPool::AdmitWaiting(std::unique_lock<std::mutex> &lock)
+{
+    std::vector<std::function<void()>> admitted;
+    while (!waiting_.empty() && (max_concurrency_ <= 0 || running_ < max_concurrency_))
+    {
+        ++running_;
+        admitted.push_back(std::move(waiting_.front()));
+        waiting_.pop_front();
+    }
+    lock.unlock();
+
+    for (auto &on_free : admitted)
+        on_free();
+}
+
+ModelPool::RunSlot::RunSlot()
+{
+    ModelPool &pool = Instance();
+    std::lock_guard<std::mutex> lock(pool.slots_mutex_);
+    ++pool.running_;
+}
+
+ModelPool::RunSlot::RunSlot(std::adopt_lock_t)
+{
+}
+
+ModelPool::RunSlot::~RunSlot()
+{
+    ModelPool &pool = Instance();
+    std::unique_lock<std::mutex> lock(pool.slots_mutex_);
+    --pool.running_;
+    pool.AdmitWaiting(lock);
+}
+
+}   // namespace OCR
@@ -0,0 +1,78 @@
+#ifndef MODEL_POOL_H_
+#define MODEL_POOL_H_
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+
+#include <net.h>
+
+namespace OCR
+{
+
+// Process-wide pool of loaded models, shared by every OCREngine in the
+// process including those created from different Node worker_threads.
+// A loaded ncnn::Net is never modified again and create_extractor() is const,
+// so engines sharing a model only need their own extractors.
+class ModelPool
+{
+public:
+    static ModelPool & Instance();
+
+    // disable copy
+    ModelPool(const ModelPool &) = delete;
+    ModelPool & operator = (const ModelPool &) = delete;
+
+    // loads model_path.param/.bin on first use, nullptr if loading fails;
+    // the model is released when the last engine using it goes away
+    std::shared_ptr<const ncnn::Net> GetNet(const std::string &model_path, const bool is_fp16);
+
+    // upper bound of OCR runs executing at the same time, <= 0 means unlimited
+    void SetMaxConcurrency(const int max_concurrency);
+    int GetMaxConcurrency() const;
+
+    // takes a run slot and returns true when one is free; otherwise returns false
+    // and calls on_free later, from the thread releasing a slot, with the slot
+    // already taken for the caller; never blocks
+    bool TryAcquireSlot(std::function<void()> on_free);
+
+    // holds one of the max_concurrency run slots while alive
+    class RunSlot
+    {
+    public:
+        // takes a slot without waiting, past the limit if needed: sync calls run on
+        // the JS thread that queues admitted async runs, waiting there could hold
+        // the slot it waits for forever. Async runs wait until it is released
+        RunSlot();
+        // takes over a slot granted by TryAcquireSlot
+        explicit RunSlot(std::adopt_lock_t);
+        ~RunSlot();
+
+        RunSlot(const RunSlot &) = delete;
+        RunSlot & operator = (const RunSlot &) = delete;
+    };
+
+private:
+    ModelPool() = default;
+
+    // hands free slots to queued callers in order, unlocks before calling on_free
+    // since it may release its slot right away
+    void AdmitWaiting(std::unique_lock<std::mutex> &lock);
+
+    std::mutex nets_mutex_;
+    std::map<std::pair<std::string, bool>, std::weak_ptr<const ncnn::Net>> nets_;
+
+    mutable std::mutex slots_mutex_;
+    std::deque<std::function<void()>> waiting_;
+    int max_concurrency_{0};
+    int running_{0};
+};
+
+}   // namespace OCR
+
+#endif  // MODEL_POOL_H_
@@ -1,5 +1,8 @@
+#include <atomic>
+#include <thread>
 #include <utility>
 #include <fstream>
+#include <algorithm>
 #include <stdexcept>
 #include <filesystem>
 
@@ -39,6 +42,15 @@ T GetJValue(const nlohmann::json &json, const std::vector<std::string> &keys, co
     }
 }
 
+// images handed from one pipeline stage to the next
+struct PipelineJob
+{
+    size_t index{0};
+    float upright_score{-1.0f};         // >= 0 once the page pre-pass made the page upright, cls is skipped
+    std::vector<cv::Mat> text_images{};         // crops at the rec height, turned for rec after cls
+    std::vector<OCR::Angle> angles{};
+};
+
 }   // unnamed namespace
 
 namespace OCR
@@ -54,6 +66,8 @@ OCREngine::OCREngine(OCREngine &&other) noexcept
     , det_net_(std::move(other.det_net_))
     , cls_net_(std::move(other.cls_net_))
     , rec_net_(std::move(other.rec_net_))
+    , pool_(std::move(other.pool_))
+    , pipeline_stats_(std::exchange(other.pipeline_stats_, {}))
 {
 
 }
@@ -66,6 +80,8 @@ OCREngine & OCREngine::operator = (OCREngine &&other) noexcept
         det_net_ = std::move(other.det_net_);
         cls_net_ = std::move(other.cls_net_);
         rec_net_ = std::move(other.rec_net_);
+        pool_ = std::move(other.pool_);
+        pipeline_stats_ = std::exchange(other.pipeline_stats_, {});
     }
     return *this;
 }
@@ -87,9 +103,11 @@ bool OCREngine::Initialize(const std::string &config_path)
 
     // read config
     config_.is_save = GetJValue(j, {"save"}, false);
+    config_.threads = GetThreads(GetJValue(j, {"threads"}, -1));
 
+    // ncnn threads never exceed the core budget
     DetConfig &det_config = config_.det_config;
-    det_config.infer_threads = GetThreads(GetJValue(j, {"det", "infer_threads"}, 1));
+    det_config.infer_threads = std::min(GetThreads(GetJValue(j, {"det", "infer_threads"}, 1)), config_.threads);
     det_config.model_path = GetJValue(j, {"det", "model_path"}, std::string());
     det_config.padding = GetJValue(j, {"det","padding"}, 50);
     det_config.max_side_len = GetJValue(j, {"det","max_side_len"}, 50);
@@ -97,33 +115,50 @@ bool OCREngine::Initialize(const std::string &config_path)
     det_config.bitmap_thres = GetJValue(j, {"det", "bitmap_thres"}, 0.3f);
     det_config.unclip_ratio = GetJValue(j, {"det", "unclip_ratio"}, 1.6f);
     det_config.is_fp16 = GetJValue(j, {"det", "fp16"}, false);
+    det_config.use_ccl = GetJValue(j, {"det", "ccl"}, false);
 
     ClsConfig &cls_config = config_.cls_config;
-    cls_config.infer_threads = GetThreads(GetJValue(j, {"cls", "infer_threads"}, 1));
-    cls_config.reco_threads = GetThreads(GetJValue(j, {"cls", "reco_threads"}, 1));
+    cls_config.infer_threads = std::min(GetThreads(GetJValue(j, {"cls", "infer_threads"}, 1)), config_.threads);
     cls_config.model_path = GetJValue(j, {"cls", "model_path"}, std::string());
     cls_config.enable = GetJValue(j, {"cls", "enable"}, true);
     cls_config.most_angle = GetJValue(j, {"cls", "most_angle"}, true);
     cls_config.is_fp16 = GetJValue(j, {"cls", "fp16"}, false);
+    cls_config.batch_size = std::max(1, GetJValue(j, {"cls", "batch_size"}, 8));
+    cls_config.vote_lines = std::max(0, GetJValue(j, {"cls", "vote_lines"}, 0));
+    cls_config.vote_thres = GetJValue(j, {"cls", "vote_thres"}, 0.9f);
 
     RecConfig &rec_config = config_.rec_config;
-    rec_config.infer_threads = GetThreads(GetJValue(j, {"rec", "infer_threads"}, 1));
-    rec_config.reco_threads = GetThreads(GetJValue(j, {"rec", "reco_threads"}, 1));
+    rec_config.infer_threads = std::min(GetThreads(GetJValue(j, {"rec", "infer_threads"}, 1)), config_.threads);
     rec_config.model_path = GetJValue(j, {"rec", "model_path"}, std::string());
     rec_config.keys_path = GetJValue(j, {"rec", "keys_path"}, std::string());
     rec_config.is_fp16 = GetJValue(j, {"rec", "fp16"}, false);
+    rec_config.batch_size = std::max(1, GetJValue(j, {"rec", "batch_size"}, 8));
+
+    PipelineConfig &pipeline_config = config_.pipeline_config;
+    pipeline_config.enable = GetJValue(j, {"pipeline", "enable"}, false);
+    pipeline_config.det_workers = std::max(1, GetJValue(j, {"pipeline", "det_workers"}, 1));
+    pipeline_config.cls_workers = std::max(1, GetJValue(j, {"pipeline", "cls_workers"}, 1));
+    pipeline_config.rec_workers = std::max(1, GetJValue(j, {"pipeline", "rec_workers"}, 1));
+    pipeline_config.queue_size = std::max(1, GetJValue(j, {"pipeline", "queue_size"}, 2));
+
+    PageConfig &page_config = config_.page_config;
+    page_config.enable = GetJValue(j, {"page", "enable"}, false);
+    page_config.max_side_len = GetJValue(j, {"page", "max_side_len"}, 512);
+    page_config.sample_lines = std::max(1, GetJValue(j, {"page", "sample_lines"}, 8));
+    page_config.score_thres = GetJValue(j, {"page", "score_thres"}, 0.9f);
 
     // show configs
     ShowConfig();
 
-    // create nets
+    // create nets, they share one pool
+    pool_ = std::make_shared<ThreadPool>(config_.threads);
     det_net_ = std::make_unique<DBNet>();
     cls_net_ = std::make_unique<AngleNet>();
     rec_net_ = std::make_unique<CRNNNet>();
 
-    if (!det_net_->Initialize(det_config) ||
-        !cls_net_->Initialize(cls_config) ||
-        !rec_net_->Initialize(rec_config))
+    if (!det_net_->Initialize(det_config, pool_) ||
+        !cls_net_->Initialize(cls_config, pool_) ||
+        !rec_net_->Initialize(rec_config, pool_))
     {
         det_net_.reset();
         cls_net_.reset();
@@ -134,75 +169,497 @@ bool OCREngine::Initialize(const std::string &config_path)
     return true;
 }
 
-std::vector<OCRResult> OCREngine::Run(const cv::Mat &image) const
+std::vector<OCRResult> OCREngine::Run(const cv::Mat &image, const ResultCallback &on_result,
+    const CancelToken *cancel) const
+{
+    auto results = RunBatch(std::vector<cv::Mat>{image}, on_result, cancel);
+    return results.empty() ? std::vector<OCRResult>{} : std::move(results.front());
+}
+
+std::vector<std::vector<OCRResult>> OCREngine::RunBatch(const std::vector<cv::Mat> &images,
+    const ResultCallback &on_result, const CancelToken *cancel) const
+{
+    return RunImpl(images, false, on_result, cancel);
+}
+
+std::vector<TextBox> OCREngine::DetectBoxes(const cv::Mat &image) const
+{
+    if (!det_net_)
+    {
+        PLOGW << "Return an empty result since det_net == nullptr";
+        return {};
+    }
+
+    return det_net_->Det(image);
+}
+
+std::vector<std::vector<OCRResult>> OCREngine::RunLines(const std::vector<cv::Mat> &images,
+    const ResultCallback &on_result, const CancelToken *cancel) const
+{
+    return RunImpl(images, true, on_result, cancel);
+}
+
+std::vector<OCRResult> OCREngine::Recognize(const std::vector<cv::Mat> &text_images, const CancelToken *cancel) const
 {
-    if (!det_net_ || !cls_net_ || !rec_net_)
+    auto line_results = RunImpl(text_images, true, nullptr, cancel);
+
+    std::vector<OCRResult> results;
+    results.reserve(line_results.size());
+    for (auto &line_result : line_results)
+    {
+        for (auto &result : line_result)
+            results.emplace_back(std::move(result));
+    }
+    return results;
+}
+
+PipelineStats OCREngine::GetPipelineStats() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return pipeline_stats_;
+}
+
+std::vector<std::vector<OCRResult>> OCREngine::RunImpl(const std::vector<cv::Mat> &images, const bool line_mode,
+    const ResultCallback &on_result, const CancelToken *cancel) const
+{
+    if ((!line_mode && !det_net_) || !cls_net_ || !rec_net_)
     {
         PLOGW << "Return an empty result since ( "
             << (!det_net_ ? "det_net " : "")
             << (!cls_net_ ? "cls_net " : "")
             << (!rec_net_ ? "rec_net " : "")
             << ") == nullptr";
-        return {};
+        return std::vector<std::vector<OCRResult>>(images.size());
     }
 
+    // a single image has nothing to overlap with
+    if (config_.pipeline_config.enable && images.size() > 1)
+        return RunPipelined(images, line_mode, on_result, cancel);
+
     // timers
     double det_time{}, cls_time{}, rec_time{}, total_time{};
 
     // 1. Text Detection
     total_time = det_time = cv::getTickCount();
 
-    auto text_boxes = det_net_->Det(image);
+    std::vector<std::vector<TextBox>> text_boxes(images.size());
+    std::vector<cv::Mat> page_images(images.begin(), images.end());
+    std::vector<PageOrientation> pages(images.size());
+    for (size_t k = 0; k < images.size(); ++k)
+    {
+        if (line_mode)
+        {
+            // the whole image is the text line
+            const int r = images[k].cols - 1, b = images[k].rows - 1;
+            text_boxes[k] = {TextBox{{{0, 0}, {r, 0}, {r, b}, {0, b}}, 1.0f}};
+            continue;
+        }
+        if (cancel && cancel->Expired())
+            break;
+        text_boxes[k] = DetectPage(images[k], page_images[k], pages[k]);
+    }
 
     det_time = (cv::getTickCount() - det_time) / cv::getTickFrequency() * 1000.0;
 
-    // rotate and crop images
-    std::vector<cv::Mat> text_images(text_boxes.size());
-    for (size_t i = 0; i < text_boxes.size(); ++i)
+    // crop lines at the rec height for cls and rec, lines of image k are
+    // [offsets[k], offsets[k + 1])
+    std::vector<size_t> offsets(images.size() + 1, 0);
+    for (size_t k = 0; k < images.size(); ++k)
+        offsets[k + 1] = offsets[k] + text_boxes[k].size();
+
+    // nothing is recognized when cancelled before rec starts
+    const bool skip_lines = offsets.back() == 0 || (cancel && cancel->Expired());
+
+    std::vector<cv::Mat> text_images(skip_lines ? 0 : offsets.back());
+    for (size_t k = 0; k < images.size() && !skip_lines; ++k)
     {
-        text_images[i] = GetRotatedCropImage(image, text_boxes[i].points);
+        auto crop_images = GetRecImages(page_images[k], text_boxes[k], line_mode);
+        std::move(crop_images.begin(), crop_images.end(), text_images.begin() + offsets[k]);
     }
 
+    // results are in image coordinates
+    for (size_t k = 0; k < images.size(); ++k)
+        MapPageBoxes(text_boxes[k], pages[k].rotation, images[k].size());
+
     // 2. Handle Angle
     cls_time = cv::getTickCount();
 
-    auto angles = cls_net_->Cls(text_images);
+    // lines of confidently upright pages are not classified
+    std::vector<cv::Mat> cls_images;
+    std::vector<size_t> cls_offsets{0};
+    std::vector<float> box_scores;
+    for (size_t k = 0; k < images.size() && !text_images.empty(); ++k)
+    {
+        if (pages[k].confident)
+            continue;
+        for (size_t i = 0; i < text_boxes[k].size(); ++i)
+        {
+            cls_images.emplace_back(text_images[offsets[k] + i]);
+            box_scores.emplace_back(text_boxes[k][i].score);
+        }
+        cls_offsets.emplace_back(cls_images.size());
+    }
+
+    auto cls_angles = cls_net_->Cls(cls_images, cls_offsets, box_scores, cancel);
+    if (cancel && cancel->Interrupted())
+        text_images.clear();
+
+    std::vector<Angle> angles(text_images.size());
+    for (size_t k = 0, j = 0; k < images.size() && !text_images.empty(); ++k)
+    {
+        for (size_t i = offsets[k]; i < offsets[k + 1]; ++i)
+            angles[i] = pages[k].confident ? Angle{false, pages[k].score} : cls_angles[j++];
+    }
 
     cls_time = (cv::getTickCount() - cls_time) / cv::getTickFrequency() * 1000.0;
 
-    // rotate images
+    // turn upside down lines for rec, on the small crops
     for (size_t i = 0; i < text_images.size(); ++i)
     {
         if (angles[i].is_rot)
-            cv::rotate(text_images[i], text_images[i], cv::ROTATE_180);
+        {
+            cv::Mat rot_image;
+            cv::rotate(text_images[i], rot_image, cv::ROTATE_180);
+            text_images[i] = rot_image;
+        }
     }
 
     // 3. Recognize Text
     rec_time = cv::getTickCount();
 
-    auto text_lines = rec_net_->Rec(text_images);
+    // lines skipped after a cancellation are never marked as recognized
+    std::vector<uint8_t> recognized(text_images.size(), 0);
+    auto on_line = [&](size_t i, const TextLine &text_line)
+    {
+        recognized[i] = 1;
+
+        // report each line as soon as it is recognized
+        if (on_result)
+        {
+            size_t k = std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1;
+            on_result(k, i - offsets[k], OCRResult{text_boxes[k][i - offsets[k]], angles[i], text_line});
+        }
+    };
+
+    auto text_lines = rec_net_->Rec(text_images, on_line, cancel);
 
     rec_time = (cv::getTickCount() - rec_time) / cv::getTickFrequency() * 1000.0;
 
-    std::vector<OCRResult> results(text_lines.size());
-    for (size_t i = 0; i < text_lines.size(); ++i)
+    std::vector<std::vector<OCRResult>> results(images.size());
+    for (size_t k = 0; k < images.size() && !text_images.empty(); ++k)
     {
-        results[i].line = text_lines[i];
-        results[i].angle = angles[i];
-        results[i].box = text_boxes[i];
+        results[k].reserve(text_boxes[k].size());
+        for (size_t i = 0; i < text_boxes[k].size(); ++i)
+        {
+            if (recognized[offsets[k] + i])
+                results[k].emplace_back(OCRResult{text_boxes[k][i], angles[offsets[k] + i], text_lines[offsets[k] + i]});
+        }
     }
 
     // timer
     total_time = (cv::getTickCount() - total_time) / cv::getTickFrequency() * 1000.0;
-    PLOGI.printf("det_time(%.2fms), cls_time(%.2fms), rec_time(%.2fms), total(%.2fms)",
-        det_time, cls_time, rec_time, total_time);
+    PLOGI.printf("images(%zu), lines(%zu), det_time(%.2fms), cls_time(%.2fms), rec_time(%.2fms), total(%.2fms)%s",
+        images.size(), text_images.size(), det_time, cls_time, rec_time, total_time,
+        cancel && cancel->Interrupted() ? ", interrupted" : "");
 
     // save results for debugging
-    SaveResults(image, text_boxes, text_images, results);
+    if (config_.is_save && !(cancel && cancel->Interrupted()))
+    {
+        for (size_t k = 0; k < images.size(); ++k)
+        {
+            std::vector<cv::Mat> image_texts(text_images.begin() + offsets[k], text_images.begin() + offsets[k + 1]);
+            SaveResults(images[k], text_boxes[k], image_texts, results[k],
+                images.size() == 1 ? "check" : "check/" + std::to_string(k));
+        }
+    }
 
     return results;
 }
 
+std::vector<std::vector<OCRResult>> OCREngine::RunPipelined(const std::vector<cv::Mat> &images, const bool line_mode,
+    const ResultCallback &on_result, const CancelToken *cancel) const
+{
+    const PipelineConfig &pipeline_config = config_.pipeline_config;
+
+    // timer
+    double total_time = cv::getTickCount();
+
+    std::vector<std::vector<TextBox>> text_boxes(images.size());
+    std::vector<std::vector<OCRResult>> results(images.size());
+    std::atomic<size_t> num_lines{0};
+
+    BoundedQueue<PipelineJob> cls_queue(pipeline_config.queue_size);
+    BoundedQueue<PipelineJob> rec_queue(pipeline_config.queue_size);
+
+    // once cancel expires the stages keep draining their queues without working,
+    // so no producer stays blocked on a full queue
+    const auto expired = [cancel]() { return cancel && cancel->Expired(); };
+
+    // 1. Text Detection, images are taken in input order
+    std::atomic<size_t> next_image{0};
+    std::atomic<int> det_running{pipeline_config.det_workers};
+    auto det_stage = [&]()
+    {
+        for (size_t k = next_image++; k < images.size() && !expired(); k = next_image++)
+        {
+            PipelineJob job{k};
+            if (line_mode)
+            {
+                // the whole image is the text line
+                const int r = images[k].cols - 1, b = images[k].rows - 1;
+                text_boxes[k] = {TextBox{{{0, 0}, {r, 0}, {r, b}, {0, b}}, 1.0f}};
+                job.text_images = GetRecImages(images[k], text_boxes[k], line_mode);
+            }
+            else
+            {
+                cv::Mat page_image = images[k];
+                PageOrientation page;
+                text_boxes[k] = DetectPage(images[k], page_image, page);
+                if (text_boxes[k].empty() || expired())
+                    continue;
+
+                job.text_images = GetRecImages(page_image, text_boxes[k], line_mode);
+
+                MapPageBoxes(text_boxes[k], page.rotation, images[k].size());
+                if (page.confident)
+                    job.upright_score = page.score;
+            }
+            cls_queue.Push(std::move(job));
+        }
+        if (--det_running == 0)
+            cls_queue.Close();
+    };
+
+    // 2. Handle Angle
+    std::atomic<int> cls_running{pipeline_config.cls_workers};
+    auto cls_stage = [&]()
+    {
+        PipelineJob job;
+        while (cls_queue.Pop(job))
+        {
+            if (expired())
+                continue;
+
+            if (job.upright_score >= 0.0f)
+            {
+                job.angles.assign(job.text_images.size(), Angle{false, job.upright_score});
+                rec_queue.Push(std::move(job));
+                continue;
+            }
+
+            std::vector<float> box_scores;
+            for (const auto &text_box : text_boxes[job.index])
+                box_scores.emplace_back(text_box.score);
+
+            job.angles = cls_net_->Cls(job.text_images, {0, job.text_images.size()}, box_scores, cancel);
+            if (cancel && cancel->Interrupted())
+                continue;
+
+            // turn upside down lines for rec, on the small crops
+            for (size_t i = 0; i < job.text_images.size(); ++i)
+            {
+                if (job.angles[i].is_rot)
+                {
+                    cv::Mat rot_image;
+                    cv::rotate(job.text_images[i], rot_image, cv::ROTATE_180);
+                    job.text_images[i] = rot_image;
+                }
+            }
+            rec_queue.Push(std::move(job));
+        }
+        if (--cls_running == 0)
+            rec_queue.Close();
+    };
+
+    // 3. Recognize Text
+    auto rec_stage = [&]()
+    {
+        PipelineJob job;
+        while (rec_queue.Pop(job))
+        {
+            if (expired())
+                continue;
+
+            const size_t k = job.index;
+            std::vector<uint8_t> recognized(job.text_images.size(), 0);
+            auto on_line = [&](size_t i, const TextLine &text_line)
+            {
+                recognized[i] = 1;
+                if (on_result)
+                    on_result(k, i, OCRResult{text_boxes[k][i], job.angles[i], text_line});
+            };
+
+            auto text_lines = rec_net_->Rec(job.text_images, on_line, cancel);
+
+            results[k].reserve(text_lines.size());
+            for (size_t i = 0; i < text_lines.size(); ++i)
+            {
+                if (recognized[i])
+                    results[k].emplace_back(OCRResult{text_boxes[k][i], job.angles[i], text_lines[i]});
+            }
+            num_lines += job.text_images.size();
+
+            // save results for debugging
+            if (config_.is_save && !(cancel && cancel->Interrupted()))
+                SaveResults(images[k], text_boxes[k], job.text_images, results[k], "check/" + std::to_string(k));
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < pipeline_config.det_workers; ++i)
+        workers.emplace_back(det_stage);
+    for (int i = 0; i < pipeline_config.cls_workers; ++i)
+        workers.emplace_back(cls_stage);
+    for (int i = 0; i < pipeline_config.rec_workers; ++i)
+        workers.emplace_back(rec_stage);
+    for (auto &worker : workers)
+        worker.join();
+
+    const QueueStats cls_stats = cls_queue.Stats(), rec_stats = rec_queue.Stats();
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++pipeline_stats_.runs;
+        pipeline_stats_.images += images.size();
+        pipeline_stats_.cls_queue.Merge(cls_stats);
+        pipeline_stats_.rec_queue.Merge(rec_stats);
+    }
+
+    // timer
+    total_time = (cv::getTickCount() - total_time) / cv::getTickFrequency() * 1000.0;
+    PLOGI.printf("images(%zu), lines(%zu), cls_queue(max %zu, mean %.2f, full %zu), "
+        "rec_queue(max %zu, mean %.2f, full %zu), total(%.2fms)%s",
+        images.size(), num_lines.load(),
+        cls_stats.max_depth, cls_stats.MeanDepth(), cls_stats.full_waits,
+        rec_stats.max_depth, rec_stats.MeanDepth(), rec_stats.full_waits, total_time,
+        cancel && cancel->Interrupted() ? ", interrupted" : "");
+
+    return results;
+}
+
+OCREngine::PageOrientation OCREngine::DetectPageOrientation(const cv::Mat &image) const
+{
+    const PageConfig &page_config = config_.page_config;
+    PageOrientation page;
+
+    // the boxes of a low resolution detection are enough to tell the text direction
+    auto text_boxes = det_net_->Det(image, page_config.max_side_len);
+    if (text_boxes.empty())
+        return page;
+
+    // same rule as GetRotatedCropImage, mostly vertical lines mean a page turned by 90 or 270 degrees
+    auto is_vertical = [](const TextBox &text_box)
+    {
+        const auto &p = text_box.points;
+        return cv::norm(p[0] - p[3]) >= cv::norm(p[0] - p[1]) * 1.5;
+    };
+
+    double vertical_area = 0.0, total_area = 0.0;
+    for (const auto &text_box : text_boxes)
+    {
+        const double area = cv::contourArea(text_box.points);
+        total_area += area;
+        if (is_vertical(text_box))
+            vertical_area += area;
+    }
+    const double vertical_ratio = total_area > 0.0 ? vertical_area / total_area : 0.0;
+    const bool vertical = vertical_ratio > 0.5;
+
+    // classify the crops of the most confident boxes along the page direction;
+    // vertical crops are turned counterclockwise, so cls only tells 0 from 180
+    std::stable_sort(text_boxes.begin(), text_boxes.end(), [](const TextBox &a, const TextBox &b)
+    {
+        return a.score > b.score;
+    });
+
+    std::vector<cv::Mat> crops;
+    for (size_t i = 0; i < text_boxes.size() && crops.size() < static_cast<size_t>(page_config.sample_lines); ++i)
+    {
+        if (is_vertical(text_boxes[i]) == vertical)
+            crops.emplace_back(GetRotatedCropImage(image, text_boxes[i].points, CRNNNet::TargetHeight()));
+    }
+
+    auto angles = cls_net_->Classify(crops);
+
+    float weights[2]{0.0f, 0.0f};   // upright, upside down
+    for (const auto &angle : angles)
+        weights[angle.is_rot] += angle.score;
+    const bool flipped = weights[1] > weights[0];
+
+    // mean score of the samples where a dissenting sample counts as 0
+    page.score = crops.empty() ? 0.0f : weights[flipped] / crops.size();
+    page.confident = page.score >= page_config.score_thres &&
+        std::max(vertical_ratio, 1.0 - vertical_ratio) >= page_config.score_thres;
+
+    if (page.confident)
+        page.rotation = vertical ? (flipped ? 90 : 270) : (flipped ? 180 : 0);
+
+    PLOGD.printf("page: vertical_ratio(%.2f) score(%.2f) samples(%zu) rotation(%d) confident(%d)",
+        vertical_ratio, page.score, crops.size(), page.rotation, page.confident);
+
+    return page;
+}
+
+std::vector<TextBox> OCREngine::DetectPage(const cv::Mat &image, cv::Mat &page_image, PageOrientation &page) const
+{
+    page_image = image;
+    if (!config_.page_config.enable)
+        return det_net_->Det(image);
+
+    page = DetectPageOrientation(image);
+    switch (page.rotation)
+    {
+        case 90: cv::rotate(image, page_image, cv::ROTATE_90_CLOCKWISE); break;
+        case 180: cv::rotate(image, page_image, cv::ROTATE_180); break;
+        case 270: cv::rotate(image, page_image, cv::ROTATE_90_COUNTERCLOCKWISE); break;
+        default: break;
+    }
+
+    return det_net_->Det(page_image);
+}
+
+void OCREngine::MapPageBoxes(std::vector<TextBox> &text_boxes, const int rotation, const cv::Size &image_size)
+{
+    const int w = image_size.width, h = image_size.height;
+    for (auto &text_box : text_boxes)
+    {
+        for (auto &point : text_box.points)
+        {
+            const cv::Point p = point;
+            switch (rotation)
+            {
+                case 90: point = {p.y, h - 1 - p.x}; break;
+                case 180: point = {w - 1 - p.x, h - 1 - p.y}; break;
+                case 270: point = {w - 1 - p.y, p.x}; break;
+                default: break;
+            }
+        }
+    }
+}
+
+std::vector<cv::Mat> OCREngine::GetRecImages(const cv::Mat &page_image, const std::vector<TextBox> &text_boxes,
+    const bool line_mode) const
+{
+    const int target_h = CRNNNet::TargetHeight();
+    if (line_mode)
+        return {GetScaledLineImage(page_image, target_h)};
+
+    std::vector<cv::Mat> rec_images(text_boxes.size());
+    pool_->ParallelFor(GetLineOrder(text_boxes.size()), [&](size_t i)
+    {
+        rec_images[i] = GetRotatedCropImage(page_image, text_boxes[i].points, target_h);
+    });
+
+    return rec_images;
+}
+
+std::vector<size_t> OCREngine::GetLineOrder(const size_t num_lines)
+{
+    std::vector<size_t> order(num_lines);
+    for (size_t i = 0; i < num_lines; ++i)
+        order[i] = i;
+    return order;
+}
+
 void OCREngine::ShowConfig() const
 {
     const DetConfig &det_config = config_.det_config;
@@ -211,19 +668,35 @@ void OCREngine::ShowConfig() const
 
     PLOGD << "--------------- Configs ---------------";
 
+    PLOGD.printf("threads(%d)", config_.threads);
+
     PLOGD << "Det config";
     PLOGD.printf("  infer_threads(%d) padding(%d) max_side_len(%d) box_thres(%.2f) "
-        "bitmap_thres(%.2f) unclip_ratio(%.2f) fp16(%d)",
+        "bitmap_thres(%.2f) unclip_ratio(%.2f) fp16(%d) ccl(%d)",
         det_config.infer_threads, det_config.padding, det_config.max_side_len,
-        det_config.box_thres, det_config.bitmap_thres, det_config.unclip_ratio, det_config.is_fp16);
+        det_config.box_thres, det_config.bitmap_thres, det_config.unclip_ratio, det_config.is_fp16,
+        det_config.use_ccl);
 
     PLOGD << "Cls config";
-    PLOGD.printf("  infer_threads(%d) reco_threads(%d) enable(%d) most_angle(%d) fp16(%d)",
-        cls_config.infer_threads, cls_config.reco_threads, cls_config.enable, cls_config.most_angle, cls_config.is_fp16);
+    PLOGD.printf("  infer_threads(%d) enable(%d) most_angle(%d) fp16(%d) batch_size(%d) "
+        "vote_lines(%d) vote_thres(%.2f)",
+        cls_config.infer_threads, cls_config.enable, cls_config.most_angle, cls_config.is_fp16,
+        cls_config.batch_size, cls_config.vote_lines, cls_config.vote_thres);
 
     PLOGD << "Rec config";
-    PLOGD.printf("  infer_threads(%d) reco_threads(%d) fp16(%d)",
-        rec_config.infer_threads, rec_config.reco_threads, rec_config.is_fp16);
+    PLOGD.printf("  infer_threads(%d) fp16(%d) batch_size(%d)",
+        rec_config.infer_threads, rec_config.is_fp16, rec_config.batch_size);
+
+    const PipelineConfig &pipeline_config = config_.pipeline_config;
+    PLOGD << "Pipeline config";
+    PLOGD.printf("  enable(%d) det_workers(%d) cls_workers(%d) rec_workers(%d) queue_size(%d)",
+        pipeline_config.enable, pipeline_config.det_workers, pipeline_config.cls_workers,
+        pipeline_config.rec_workers, pipeline_config.queue_size);
+
+    const PageConfig &page_config = config_.page_config;
+    PLOGD << "Page config";
+    PLOGD.printf("  enable(%d) max_side_len(%d) sample_lines(%d) score_thres(%.2f)",
+        page_config.enable, page_config.max_side_len, page_config.sample_lines, page_config.score_thres);
 
     PLOGD << "---------------------------------------";
 }
@@ -3,12 +3,17 @@
 
 #include <vector>
 #include <string>
+#include <mutex>
 #include <memory>
+#include <functional>
 
 #include <opencv2/opencv.hpp>
 
 #include "common.h"
 #include "config.h"
+#include "cancel_token.h"
+#include "bounded_queue.h"
+#include "thread_pool.h"
 #include "db_net.h"
 #include "angle_net.h"
 #include "crnn_net.h"
@@ -16,6 +21,15 @@
 namespace OCR
 {
 
+// queue depths of the pipelined runs of an engine, summed over all runs
+struct PipelineStats
+{
+    size_t runs{0};
+    size_t images{0};
+    QueueStats cls_queue{};     // det -> cls
+    QueueStats rec_queue{};     // cls -> rec
+};
+
 class OCREngine
 {
 public:
@@ -33,7 +47,34 @@ public:
 
     bool Initialize(const std::string &config_path);
 
-    std::vector<OCRResult> Run(const cv::Mat &image) const;
+    // called with (image index, line index, result) as soon as a line is recognized,
+    // before Run/RunBatch return; may be called from several threads at once
+    using ResultCallback = std::function<void(size_t, size_t, const OCRResult &)>;
+
+    // safe to call from several threads at once, each call uses its own extractors;
+    // once cancel expires only the lines recognized so far are returned and
+    // cancel->Interrupted() is true
+    std::vector<OCRResult> Run(const cv::Mat &image, const ResultCallback &on_result = nullptr,
+        const CancelToken *cancel = nullptr) const;
+
+    // detects every image, then classifies and recognizes the text lines of
+    // all images together so small images still fill the cls/rec threads
+    std::vector<std::vector<OCRResult>> RunBatch(const std::vector<cv::Mat> &images,
+        const ResultCallback &on_result = nullptr, const CancelToken *cancel = nullptr) const;
+
+    // detection only
+    std::vector<TextBox> DetectBoxes(const cv::Mat &image) const;
+
+    // skips detection, every image is a single text line that goes straight to cls + rec;
+    // the box of a line covers its whole image
+    std::vector<std::vector<OCRResult>> RunLines(const std::vector<cv::Mat> &images,
+        const ResultCallback &on_result = nullptr, const CancelToken *cancel = nullptr) const;
+
+    // RunLines for already cropped lines, one result per recognized crop in input order
+    std::vector<OCRResult> Recognize(const std::vector<cv::Mat> &text_images, const CancelToken *cancel = nullptr) const;
+
+    // filled while the pipeline config is enabled
+    PipelineStats GetPipelineStats() const;
 
 private:
     Config config_;
@@ -41,6 +82,46 @@ private:
     std::unique_ptr<AngleNet> cls_net_{};
     std::unique_ptr<CRNNNet> rec_net_{};
 
+    // runs the cls/rec lines of every call, sized to config_.threads
+    std::shared_ptr<ThreadPool> pool_{};
+
+    mutable std::mutex stats_mutex_;
+    mutable PipelineStats pipeline_stats_{};
+
+    std::vector<std::vector<OCRResult>> RunImpl(const std::vector<cv::Mat> &images, const bool line_mode,
+        const ResultCallback &on_result, const CancelToken *cancel) const;
+
+    // det, cls and rec stages connected by bounded queues, image k + 1 is
+    // detected while image k is classified or recognized
+    std::vector<std::vector<OCRResult>> RunPipelined(const std::vector<cv::Mat> &images, const bool line_mode,
+        const ResultCallback &on_result, const CancelToken *cancel) const;
+
+    // result of the page orientation pre-pass
+    struct PageOrientation
+    {
+        int rotation{0};            // clockwise degrees that make the page upright: 0, 90, 180 or 270
+        float score{0.0f};
+        bool confident{false};      // lines of the upright page skip per-line cls
+    };
+
+    PageOrientation DetectPageOrientation(const cv::Mat &image) const;
+
+    // detection of one image, with the page pre-pass the boxes come from the upright
+    // page and page_image is set to it so crops are taken from there
+    std::vector<TextBox> DetectPage(const cv::Mat &image, cv::Mat &page_image, PageOrientation &page) const;
+
+    // boxes detected on the page rotated by rotation back to image coordinates
+    static void MapPageBoxes(std::vector<TextBox> &text_boxes, const int rotation, const cv::Size &image_size);
+
+    // crops of the lines of one image, warped on the pool from the page straight to the
+    // rec height; cls reads them as they are and rec once upside down lines are turned
+    // by 180 degrees; in line mode page_image is the line itself
+    std::vector<cv::Mat> GetRecImages(const cv::Mat &page_image, const std::vector<TextBox> &text_boxes,
+        const bool line_mode) const;
+
+    // lines in box order, for ParallelFor
+    static std::vector<size_t> GetLineOrder(const size_t num_lines);
+
     void ShowConfig() const;
 
     void SaveResults(const cv::Mat &image, std::vector<TextBox> &text_boxes,
@@ -0,0 +1,224 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCR_SIMD_SSE2 1
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OCR_SIMD_AVX2 1
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OCR_SIMD_NEON 1
+#endif
+
+namespace OCR
+{
+
+// One pass over a DBNet probability map: score[i] is prob[i] scaled to 0..255
+// and truncated like ncnn::Mat::to_pixels, mask[i] is 255 where prob[i] > thres
+// (probability space) and 0 elsewhere.
+inline void BinarizeScoreMap(const float *prob, const size_t n, const float thres,
+    uint8_t *score, uint8_t *mask)
+{
+    size_t i = 0;
+
+#if defined(OCR_SIMD_SSE2)
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 threshold = _mm_set1_ps(thres);
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128 p0 = _mm_loadu_ps(prob + i);
+        const __m128 p1 = _mm_loadu_ps(prob + i + 4);
+        const __m128 p2 = _mm_loadu_ps(prob + i + 8);
+        const __m128 p3 = _mm_loadu_ps(prob + i + 12);
+
+        // truncate, then saturate to 0..255 through int16
+        const __m128i s01 = _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(p0, scale)),
+            _mm_cvttps_epi32(_mm_mul_ps(p1, scale)));
+        const __m128i s23 = _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(p2, scale)),
+            _mm_cvttps_epi32(_mm_mul_ps(p3, scale)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(score + i), _mm_packus_epi16(s01, s23));
+
+        // all-ones lanes stay -1, i.e. 0xff, through the signed packs
+        const __m128i m01 = _mm_packs_epi32(_mm_castps_si128(_mm_cmpgt_ps(p0, threshold)),
+            _mm_castps_si128(_mm_cmpgt_ps(p1, threshold)));
+        const __m128i m23 = _mm_packs_epi32(_mm_castps_si128(_mm_cmpgt_ps(p2, threshold)),
+            _mm_castps_si128(_mm_cmpgt_ps(p3, threshold)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(mask + i), _mm_packs_epi16(m01, m23));
+    }
+#elif defined(OCR_SIMD_NEON)
+    const float32x4_t scale = vdupq_n_f32(255.0f);
+    const float32x4_t threshold = vdupq_n_f32(thres);
+    for (; i + 8 <= n; i += 8)
+    {
+        const float32x4_t p0 = vld1q_f32(prob + i);
+        const float32x4_t p1 = vld1q_f32(prob + i + 4);
+
+        // truncate, then saturate to 0..255 through int16
+        const int16x8_t s = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(vmulq_f32(p0, scale))),
+            vqmovn_s32(vcvtq_s32_f32(vmulq_f32(p1, scale))));
+        vst1_u8(score + i, vqmovun_s16(s));
+
+        const uint16x8_t m = vcombine_u16(vmovn_u32(vcgtq_f32(p0, threshold)),
+            vmovn_u32(vcgtq_f32(p1, threshold)));
+        vst1_u8(mask + i, vmovn_u16(m));
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        const int v = static_cast<int>(prob[i] * 255.0f);
+        score[i] = static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+        mask[i] = prob[i] > thres ? 255 : 0;
+    }
+}
+
+// sum of n bytes
+inline uint32_t RowSum(const uint8_t *row, const size_t n)
+{
+    size_t i = 0;
+    uint32_t sum = 0;
+
+#if defined(OCR_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; i + 16 <= n; i += 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i)), zero));
+    sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(acc, acc)));
+#elif defined(OCR_SIMD_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= n; i += 16)
+        acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(row + i)));
+    sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+
+    for (; i < n; ++i)
+        sum += row[i];
+    return sum;
+}
+
+// index of the first largest of n floats like std::max_element, max_v is set to it;
+// each lane keeps its own first maximum, ties between lanes go to the lower index
+inline int ArgMax(const float *row, const int n, float &max_v)
+{
+    int i = 0, max_i = 0;
+    max_v = row[0];
+
+#if defined(OCR_SIMD_AVX2)
+    if (n >= 8)
+    {
+        __m256 lane_v = _mm256_loadu_ps(row);
+        __m256i lane_i = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i cur_i = lane_i;
+        const __m256i step = _mm256_set1_epi32(8);
+        for (i = 8; i + 8 <= n; i += 8)
+        {
+            const __m256 v = _mm256_loadu_ps(row + i);
+            cur_i = _mm256_add_epi32(cur_i, step);
+            const __m256 gt = _mm256_cmp_ps(v, lane_v, _CMP_GT_OQ);
+            lane_v = _mm256_blendv_ps(lane_v, v, gt);
+            lane_i = _mm256_blendv_epi8(lane_i, cur_i, _mm256_castps_si256(gt));
+        }
+
+        alignas(32) float vs[8];
+        alignas(32) int32_t is[8];
+        _mm256_store_ps(vs, lane_v);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(is), lane_i);
+        max_v = vs[0];
+        max_i = is[0];
+        for (int k = 1; k < 8; ++k)
+        {
+            if (vs[k] > max_v || (vs[k] == max_v && is[k] < max_i))
+            {
+                max_v = vs[k];
+                max_i = is[k];
+            }
+        }
+    }
+#elif defined(OCR_SIMD_SSE2)
+    if (n >= 4)
+    {
+        __m128 lane_v = _mm_loadu_ps(row);
+        __m128i lane_i = _mm_setr_epi32(0, 1, 2, 3);
+        __m128i cur_i = lane_i;
+        const __m128i step = _mm_set1_epi32(4);
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            const __m128 v = _mm_loadu_ps(row + i);
+            cur_i = _mm_add_epi32(cur_i, step);
+
+            // no blend before SSE4.1, select through the compare mask
+            const __m128 gt = _mm_cmpgt_ps(v, lane_v);
+            const __m128i gt_i = _mm_castps_si128(gt);
+            lane_v = _mm_or_ps(_mm_and_ps(gt, v), _mm_andnot_ps(gt, lane_v));
+            lane_i = _mm_or_si128(_mm_and_si128(gt_i, cur_i), _mm_andnot_si128(gt_i, lane_i));
+        }
+
+        alignas(16) float vs[4];
+        alignas(16) int32_t is[4];
+        _mm_store_ps(vs, lane_v);
+        _mm_store_si128(reinterpret_cast<__m128i *>(is), lane_i);
+        max_v = vs[0];
+        max_i = is[0];
+        for (int k = 1; k < 4; ++k)
+        {
+            if (vs[k] > max_v || (vs[k] == max_v && is[k] < max_i))
+            {
+                max_v = vs[k];
+                max_i = is[k];
+            }
+        }
+    }
+#elif defined(OCR_SIMD_NEON)
+    if (n >= 4)
+    {
+        float32x4_t lane_v = vld1q_f32(row);
+        const int32_t first[4]{0, 1, 2, 3};
+        int32x4_t lane_i = vld1q_s32(first);
+        int32x4_t cur_i = lane_i;
+        const int32x4_t step = vdupq_n_s32(4);
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            const float32x4_t v = vld1q_f32(row + i);
+            cur_i = vaddq_s32(cur_i, step);
+            const uint32x4_t gt = vcgtq_f32(v, lane_v);
+            lane_v = vbslq_f32(gt, v, lane_v);
+            lane_i = vbslq_s32(gt, cur_i, lane_i);
+        }
+
+        float vs[4];
+        int32_t is[4];
+        vst1q_f32(vs, lane_v);
+        vst1q_s32(is, lane_i);
+        max_v = vs[0];
+        max_i = is[0];
+        for (int k = 1; k < 4; ++k)
+        {
+            if (vs[k] > max_v || (vs[k] == max_v && is[k] < max_i))
+            {
+                max_v = vs[k];
+                max_i = is[k];
+            }
+        }
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        if (row[i] > max_v)
+        {
+            max_v = row[i];
+            max_i = i;
+        }
+    }
+    return max_i;
+}
+
+}   // namespace OCR
+
+#endif  // SIMD_H_
@@ -0,0 +1,113 @@
+#include "thread_pool.h"
+
+namespace OCR
+{
+
+ThreadPool::ThreadPool(const int threads)
+{
+    const size_t num_workers = threads > 1 ? threads - 1 : 0;
+    for (size_t i = 0; i < num_workers; ++i)
+        queues_.emplace_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < num_workers; ++i)
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(const std::vector<size_t> &order, const std::function<void(size_t)> &fn)
+{
+    if (order.empty())
+        return;
+
+    // nothing to share, skip the queues
+    if (queues_.empty() || order.size() == 1)
+    {
+        for (size_t i : order)
+            fn(i);
+        return;
+    }
+
+    Batch batch;
+    batch.fn = &fn;
+    batch.remaining = order.size();
+
+    // counted before they are queued so pending_ never drops below zero
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ += order.size();
+    }
+
+    // deal the tasks round-robin, so each queue keeps the given order
+    for (size_t j = 0; j < order.size(); ++j)
+    {
+        Queue &queue = *queues_[j % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{&batch, order[j]});
+    }
+    wake_.notify_all();
+
+    // help until no task is left, these may belong to other batches
+    Task task;
+    while (Pop(0, task))
+        Run(task);
+
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch] { return batch.remaining == 0; });
+}
+
+void ThreadPool::WorkerLoop(const size_t id)
+{
+    Task task;
+    for (;;)
+    {
+        if (Pop(id, task))
+        {
+            Run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0)
+            return;
+    }
+}
+
+bool ThreadPool::Pop(const size_t id, Task &task)
+{
+    for (size_t n = 0; n < queues_.size(); ++n)
+    {
+        Queue &queue = *queues_[(id + n) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Run(const Task &task)
+{
+    (*task.batch->fn)(task.index);
+
+    // notify under the lock, the batch lives on the stack of its ParallelFor
+    std::lock_guard<std::mutex> lock(task.batch->mutex);
+    if (--task.batch->remaining == 0)
+        task.batch->done.notify_all();
+}
+
+}   // namespace OCR
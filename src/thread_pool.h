@@ -0,0 +1,85 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace OCR
+{
+
+// Work-stealing pool owned by an OCREngine, sized to the core budget of one run.
+// The thread calling ParallelFor works on the tasks too, so the pool starts
+// threads - 1 workers; n runs calling it at once use up to threads - 1 + n
+// cores. Tasks are dealt round-robin to per-worker queues in the given order
+// and every queue is drained front first, so the first tasks of the order
+// start first; idle workers steal from the other queues.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(const int threads);
+    ~ThreadPool();
+
+    // disable copy
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator = (const ThreadPool &) = delete;
+
+    // core budget of one run, workers + the calling thread
+    int Size() const { return static_cast<int>(queues_.size()) + 1; }
+
+    // ncnn threads each of n concurrent tasks may use within the budget
+    int ThreadsPerTask(const size_t n) const
+    {
+        const size_t tasks = n < 1 ? 1 : (n < static_cast<size_t>(Size()) ? n : Size());
+        return Size() / static_cast<int>(tasks);
+    }
+
+    // calls fn(i) for every i in order and returns once all calls finished;
+    // several threads may run their own ParallelFor at the same time
+    void ParallelFor(const std::vector<size_t> &order, const std::function<void(size_t)> &fn);
+
+private:
+    struct Batch
+    {
+        const std::function<void(size_t)> *fn{nullptr};
+        size_t remaining{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    struct Task
+    {
+        Batch *batch{nullptr};
+        size_t index{0};
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};
+    bool stop_{false};
+
+    void WorkerLoop(const size_t id);
+
+    // own queue first, then steal from the others
+    bool Pop(const size_t id, Task &task);
+
+    void Run(const Task &task);
+};
+
+}   // namespace OCR
+
+#endif  // THREAD_POOL_H_
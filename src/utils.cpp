@@ -1,13 +1,146 @@
 #include <cmath>
 #include <string>
+#include <climits>
 #include <algorithm>
 #include <string_view>
 #include <omp.h>
 
 #include "clipper2/clipper.h"
 
+#include "simd.h"
 #include "utils.h"
 
+namespace
+{
+
+// covered columns of each row of a polygon, lo > hi for an empty row
+struct Span
+{
+    int lo;
+    int hi;
+};
+
+// pixels of the 8-connected outline cv::fillPoly draws from p1 to p2, stepped
+// exactly like cv::LineIterator with leftToRight so the same pixels are chosen
+void AddLineSpans(cv::Point p1, cv::Point p2, Span *spans)
+{
+    int dx = p2.x - p1.x, dy = p2.y - p1.y;
+    if (dx < 0)
+    {
+        dx = -dx;
+        dy = -dy;
+        std::swap(p1, p2);
+    }
+    const int step_y = dy < 0 ? -1 : 1;
+    dy = std::abs(dy);
+
+    const bool vert = dy > dx;
+    if (vert)
+        std::swap(dx, dy);
+
+    int err = dx - (dy + dy);
+    const int plus_delta = dx + dx, minus_delta = -(dy + dy);
+    int x = p1.x, y = p1.y;
+    for (int n = 0; n <= dx; ++n)
+    {
+        spans[y].lo = std::min(spans[y].lo, x);
+        spans[y].hi = std::max(spans[y].hi, x);
+
+        const bool plus = err < 0;
+        err += minus_delta + (plus ? plus_delta : 0);
+        if (vert)
+        {
+            y += step_y;
+            x += plus;
+        }
+        else
+        {
+            x += 1;
+            y += plus ? step_y : 0;
+        }
+    }
+}
+
+// interior rows of a 4-point polygon, the same 16.16 fixed-point edge walk as
+// cv::fillPoly: each row fills from ceil(left edge) to floor(right edge)
+void AddFillSpans(const cv::Point *points, const int rows, Span *spans)
+{
+    constexpr int kShift = 16;
+    struct Edge
+    {
+        int64_t x, dx;
+        int y0, y1;
+    } edges[4];
+
+    int num_edges = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        const cv::Point &a = points[(i + 3) % 4], &b = points[i];
+        if (a.y == b.y)
+            continue;
+
+        const int64_t ax = static_cast<int64_t>(a.x) << kShift, bx = static_cast<int64_t>(b.x) << kShift;
+        Edge &edge = edges[num_edges++];
+        edge.dx = (bx - ax) / (b.y - a.y);
+        edge.y0 = std::min(a.y, b.y);
+        edge.y1 = std::max(a.y, b.y);
+        edge.x = a.y < b.y ? ax : bx;
+    }
+
+    for (int y = 0; y < rows; ++y)
+    {
+        int64_t xs[4];
+        int n = 0;
+        for (int e = 0; e < num_edges; ++e)
+        {
+            if (y >= edges[e].y0 && y < edges[e].y1)
+                xs[n++] = edges[e].x + (y - edges[e].y0) * edges[e].dx;
+        }
+        std::sort(xs, xs + n);
+
+        for (int k = 0; k + 1 < n; k += 2)
+        {
+            const int x1 = static_cast<int>((xs[k] + (1 << kShift) - 1) >> kShift);
+            const int x2 = static_cast<int>(xs[k + 1] >> kShift);
+            if (x1 <= x2)
+            {
+                spans[y].lo = std::min(spans[y].lo, x1);
+                spans[y].hi = std::max(spans[y].hi, x2);
+            }
+        }
+    }
+}
+
+// fillPoly + mean over a mask, used when the box pokes out of the score map
+float BoxScoreMasked(const cv::Point *box, const cv::Mat &binary, const cv::Rect &rect)
+{
+    cv::Mat mask = cv::Mat::zeros(rect.height, rect.width, CV_8UC1);
+
+    const cv::Point *pts[1] = {box};
+    int npts[]{4};
+    cv::fillPoly(mask, pts, npts, 1, cv::Scalar(1.0));
+
+    cv::Mat crop_image = binary(rect).clone();
+    return static_cast<float>(cv::mean(crop_image, mask)[0] / 255.0);
+}
+
+// the roi a quad from GetMinBoxes covers when its edges are within a pixel of the
+// axes; its crop_w x crop_h crop is then the roi itself, no warp needed
+bool GetAxisAlignedRect(const std::vector<cv::Point> &points, const int crop_w, const int crop_h,
+    const cv::Size &image_size, cv::Rect &rect)
+{
+    if (crop_w <= 0 || crop_h <= 0 || points[1].x <= points[0].x || points[3].y <= points[0].y)
+        return false;
+    if (std::abs(points[0].y - points[1].y) > 1 || std::abs(points[3].y - points[2].y) > 1 ||
+        std::abs(points[0].x - points[3].x) > 1 || std::abs(points[1].x - points[2].x) > 1)
+        return false;
+
+    rect = cv::Rect(points[0].x, points[0].y, crop_w, crop_h) & cv::Rect(0, 0, image_size.width, image_size.height);
+    return rect.width == crop_w && rect.height == crop_h;
+}
+
+}   // unnamed namespace
+
 namespace OCR
 {
 
@@ -70,20 +203,41 @@ float BoxScoreFast(const std::vector<cv::Point2f> &boxes, const cv::Mat &binary)
     min_y = Clamp(std::floor(min_y), 0.0f, h - 1.0f);
     max_y = Clamp(std::floor(max_y), 0.0f, h - 1.0f);
 
-    cv::Mat mask = cv::Mat::zeros(static_cast<int>(max_y - min_y + 1.0f), static_cast<int>(max_x - min_x + 1.0f), CV_8UC1);
+    const cv::Rect rect(static_cast<int>(min_x), static_cast<int>(min_y),
+        static_cast<int>(max_x - min_x + 1.0f), static_cast<int>(max_y - min_y + 1.0f));
 
     cv::Point box[4];
     box[0] = cv::Point(static_cast<int>(boxes[0].x - min_x), static_cast<int>(boxes[0].y - min_y));
     box[1] = cv::Point(static_cast<int>(boxes[1].x - min_x), static_cast<int>(boxes[1].y - min_y));
     box[2] = cv::Point(static_cast<int>(boxes[2].x - min_x), static_cast<int>(boxes[2].y - min_y));
     box[3] = cv::Point(static_cast<int>(boxes[3].x - min_x), static_cast<int>(boxes[3].y - min_y));
-    const cv::Point *pts[1] = {box};
-    int npts[]{4};
-    cv::fillPoly(mask, pts, npts, 1, cv::Scalar(1.0));
 
-    cv::Mat crop_image = binary(cv::Rect(static_cast<int>(min_x), static_cast<int>(min_y),
-        static_cast<int>(max_x - min_x + 1.0f), static_cast<int>(max_y - min_y + 1))).clone();
-    return static_cast<float>(cv::mean(crop_image, mask)[0] / 255.0);
+    for (const auto &point : box)
+    {
+        if (point.x < 0 || point.x >= rect.width || point.y < 0 || point.y >= rect.height)
+            return BoxScoreMasked(box, binary, rect);
+    }
+
+    // rasterize the box into one span per row like cv::fillPoly, then sum the
+    // score map along the spans; the buffer only grows with the tallest box
+    thread_local std::vector<Span> spans;
+    spans.assign(rect.height, Span{INT_MAX, -1});
+
+    for (int i = 0; i < 4; ++i)
+        AddLineSpans(box[(i + 3) % 4], box[i], spans.data());
+    AddFillSpans(box, rect.height, spans.data());
+
+    uint64_t sum = 0, count = 0;
+    for (int y = 0; y < rect.height; ++y)
+    {
+        const Span &span = spans[y];
+        if (span.lo > span.hi)
+            continue;
+        sum += RowSum(binary.ptr<uint8_t>(rect.y + y) + rect.x + span.lo, span.hi - span.lo + 1);
+        count += span.hi - span.lo + 1;
+    }
+
+    return count == 0 ? 0.0f : static_cast<float>(static_cast<double>(sum) / count / 255.0);
 }
 
 float GetUnclipDistance(const std::vector<cv::Point2f> &boxes, const float unclip_ratio)
@@ -105,15 +259,37 @@ float GetUnclipDistance(const std::vector<cv::Point2f> &boxes, const float uncli
 }
 
 cv::RotatedRect Unclip(const std::vector<cv::Point2f> &boxes, const float unclip_ratio)
+{
+    if (boxes.size() != 4)
+        return UnclipPolygon(boxes, unclip_ratio);
+
+    // boxes from GetMinBoxes are rectangles: offsetting one by d with round joins
+    // and taking the min area rect gives the same rectangle grown by d per side
+    const cv::Point2f e0 = boxes[1] - boxes[0], e1 = boxes[2] - boxes[1];
+    const cv::Point2f e2 = boxes[3] - boxes[2], e3 = boxes[0] - boxes[3];
+    const float w = std::sqrt(e0.dot(e0)), h = std::sqrt(e1.dot(e1));
+    const float eps = 1e-3f * std::max(1.0f, w + h);
+
+    const bool is_rect = std::fabs(e0.dot(e1)) <= eps * std::max(1.0f, w) * std::max(1.0f, h) &&
+        std::fabs(e0.x + e2.x) <= eps && std::fabs(e0.y + e2.y) <= eps &&
+        std::fabs(e1.x + e3.x) <= eps && std::fabs(e1.y + e3.y) <= eps;
+    if (!is_rect)
+        return UnclipPolygon(boxes, unclip_ratio);
+
+    const float distance = GetUnclipDistance(boxes, unclip_ratio);
+    const cv::Point2f center = (boxes[0] + boxes[1] + boxes[2] + boxes[3]) * 0.25f;
+    const float angle = std::atan2(e0.y, e0.x) * 180.0f / static_cast<float>(CV_PI);
+
+    return cv::RotatedRect(center, cv::Size2f(w + 2.0f * distance, h + 2.0f * distance), angle);
+}
+
+cv::RotatedRect UnclipPolygon(const std::vector<cv::Point2f> &boxes, const float unclip_ratio)
 {
     float distance = GetUnclipDistance(boxes, unclip_ratio);
 
-    Clipper2Lib::Path64 path{
-        Clipper2Lib::Point64(boxes[0].x, boxes[0].y),
-        Clipper2Lib::Point64(boxes[1].x, boxes[1].y),
-        Clipper2Lib::Point64(boxes[2].x, boxes[2].y),
-        Clipper2Lib::Point64(boxes[3].x, boxes[3].y)
-    };
+    Clipper2Lib::Path64 path;
+    for (const auto &box : boxes)
+        path.emplace_back(box.x, box.y);
 
     Clipper2Lib::Paths64 paths_in{path};
     Clipper2Lib::Paths64 soln = Clipper2Lib::InflatePaths(paths_in, distance,
@@ -136,50 +312,122 @@ cv::RotatedRect Unclip(const std::vector<cv::Point2f> &boxes, const float unclip
     return rrect;
 }
 
-cv::Mat GetRotatedCropImage(const cv::Mat &image, std::vector<cv::Point> points)
+cv::Mat GetRotatedCropImage(const cv::Mat &image, const std::vector<cv::Point> &points, const int target_h)
 {
-    auto [l, r] = std::minmax({points[0].x, points[1].x, points[2].x, points[3].x});
-    auto [t, b] = std::minmax({points[0].y, points[1].y, points[2].y, points[3].y});
+    // crop size, tall crops are turned counterclockwise
+    const int crop_w = static_cast<int>(std::sqrt(std::pow(points[0].x - points[1].x, 2) + std::pow(points[0].y - points[1].y, 2)));
+    const int crop_h = static_cast<int>(std::sqrt(std::pow(points[0].x - points[3].x, 2) + std::pow(points[0].y - points[3].y, 2)));
+    const bool rotate_90 = static_cast<float>(crop_h) >= crop_w * 1.5f;
 
-    cv::Mat crop_image = image(cv::Rect(l, t, r - l, b - t)).clone();
+    // size after the turn, resized like the rec input
+    const int line_w = std::max(rotate_90 ? crop_h : crop_w, 1);
+    const int line_h = std::max(rotate_90 ? crop_w : crop_h, 1);
+    const float ratio = static_cast<float>(target_h) / line_h;
+    const int dst_w = std::max(1, static_cast<int>(line_w * ratio));
+    const float scale_x = static_cast<float>(dst_w) / line_w, scale_y = static_cast<float>(target_h) / line_h;
 
-    for (auto &point : points)
+    // near axis-aligned lines: the roi resized, then turned on the small buffer;
+    // area averaging for lines shrunk more than twice
+    cv::Rect rect;
+    if (GetAxisAlignedRect(points, crop_w, crop_h, image.size(), rect))
     {
-        point.x -= l;
-        point.y -= t;
-    }
+        cv::Mat line_image;
+        cv::resize(image(rect), line_image, rotate_90 ? cv::Size(target_h, dst_w) : cv::Size(dst_w, target_h), 0.0, 0.0,
+            line_h > 2 * target_h ? cv::INTER_AREA : cv::INTER_LINEAR);
+        if (!rotate_90)
+            return line_image;
 
-    int crop_w = static_cast<int>(std::sqrt(std::pow(points[0].x - points[1].x, 2) + std::pow(points[0].y - points[1].y, 2)));
-    int crop_h = static_cast<int>(std::sqrt(std::pow(points[0].x - points[3].x, 2) + std::pow(points[0].y - points[3].y, 2)));
-
-    std::vector<cv::Point2f> src_pts = {
-        cv::Point2f(points[0].x, points[0].y),
-        cv::Point2f(points[1].x, points[1].y),
-        cv::Point2f(points[2].x, points[2].y),
-        cv::Point2f(points[3].x, points[3].y)
+        cv::Mat text_image;
+        cv::rotate(line_image, text_image, cv::ROTATE_90_COUNTERCLOCKWISE);
+        return text_image;
+    }
 
+    // pixel centers through warp, turn and resize, as the separate steps map them
+    auto to_dst = [&](cv::Point2f p)
+    {
+        if (rotate_90)
+            p = cv::Point2f(p.y, crop_w - 1 - p.x);
+        return cv::Point2f((p.x + 0.5f) * scale_x - 0.5f, (p.y + 0.5f) * scale_y - 0.5f);
     };
-    std::vector<cv::Point2f> dst_pts = {
-        cv::Point2f(0.0f, 0.0f),
-        cv::Point2f(crop_w, 0.0f),
-        cv::Point2f(crop_w, crop_h),
-        cv::Point2f(0.0f, crop_h)
+
+    std::vector<cv::Point2f> src_pts, dst_pts{
+        to_dst(cv::Point2f(0.0f, 0.0f)),
+        to_dst(cv::Point2f(crop_w, 0.0f)),
+        to_dst(cv::Point2f(crop_w, crop_h)),
+        to_dst(cv::Point2f(0.0f, crop_h))
     };
 
+    // the warp point-samples, so lines over twice target_h are halved first; only
+    // their bounding roi, with room for the 5x5 kernel, so the cost follows the line
+    cv::Mat source = image;
+    cv::Point2f origin(0.0f, 0.0f);
+    int halvings = 0;
+    while (line_h / static_cast<float>(2 << halvings) >= target_h)
+        ++halvings;
+    const int margin = 2 << halvings;
+    const cv::Rect bounds = cv::boundingRect(points);
+    const cv::Rect roi = cv::Rect(bounds.x - margin, bounds.y - margin, bounds.width + 2 * margin,
+        bounds.height + 2 * margin) & cv::Rect(0, 0, image.cols, image.rows);
+    if (halvings > 0 && roi.width > 1 && roi.height > 1)
+    {
+        source = image(roi);
+        origin = cv::Point2f(static_cast<float>(roi.x), static_cast<float>(roi.y));
+        for (int n = 0; n < halvings; ++n)
+        {
+            // pixel p of the roi is pixel p / 2^n after n halvings
+            if (source.rows < 2 || source.cols < 2)
+            {
+                halvings = n;
+                break;
+            }
+            cv::Mat half;
+            cv::pyrDown(source, half);
+            source = half;
+        }
+    }
+    else
+    {
+        halvings = 0;
+    }
+
+    const float scale = 1.0f / static_cast<float>(1 << halvings);
+    for (const auto &point : points)
+        src_pts.emplace_back((point.x - origin.x) * scale, (point.y - origin.y) * scale);
+
     cv::Mat pers_mat = cv::getPerspectiveTransform(src_pts, dst_pts, cv::DECOMP_LU);
 
     cv::Mat text_image;
-    cv::warpPerspective(crop_image, text_image, pers_mat, cv::Size(crop_w, crop_h), cv::BORDER_REPLICATE);
+    cv::warpPerspective(source, text_image, pers_mat, cv::Size(dst_w, target_h), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
 
-    if (static_cast<float>(text_image.rows) >= text_image.cols * 1.5f)
-    {
-        cv::Mat dst;
-        cv::rotate(text_image, dst, cv::ROTATE_90_COUNTERCLOCKWISE);
-        return dst;
-    }
     return text_image;
 }
 
+cv::Mat GetScaledLineImage(const cv::Mat &line_image, const int target_h)
+{
+    const float ratio = static_cast<float>(target_h) / line_image.rows;
+    const int dst_w = std::max(1, static_cast<int>(line_image.cols * ratio));
+
+    cv::Mat text_image;
+    cv::resize(line_image, text_image, cv::Size(dst_w, target_h));
+    return text_image;
+}
+
+std::vector<size_t> GetLongestFirstOrder(const std::vector<cv::Mat> &text_images)
+{
+    std::vector<float> widths(text_images.size());
+    for (size_t i = 0; i < text_images.size(); ++i)
+        widths[i] = text_images[i].rows > 0 ? static_cast<float>(text_images[i].cols) / text_images[i].rows : 0.0f;
+
+    std::vector<size_t> order(text_images.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&widths](size_t a, size_t b)
+    {
+        return widths[a] > widths[b];
+    });
+    return order;
+}
+
 void Trim(std::string &s)
 {
     const std::string_view pattern{" \t\n\r\f\v"};
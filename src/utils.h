@@ -15,9 +15,23 @@ float BoxScoreFast(const std::vector<cv::Point2f> &boxes, const cv::Mat &binary)
 
 float GetUnclipDistance(const std::vector<cv::Point2f> &boxes, const float unclip_ratio);
 
+// closed form for rectangles, UnclipPolygon otherwise
 cv::RotatedRect Unclip(const std::vector<cv::Point2f> &boxes, const float unclip_ratio);
 
-cv::Mat GetRotatedCropImage(const cv::Mat &image, std::vector<cv::Point> points);
+// Clipper2 round-join offset of any polygon, then its min area rect
+cv::RotatedRect UnclipPolygon(const std::vector<cv::Point2f> &boxes, const float unclip_ratio);
+
+// the crop of a text box warped straight to target_h rows: the perspective, the 90
+// degree turn of tall lines and the resize are one matrix, so no full resolution
+// crop is made; lines over twice target_h are first halved around the line only,
+// so they are filtered rather than point-sampled at the cost of their own pixels
+cv::Mat GetRotatedCropImage(const cv::Mat &image, const std::vector<cv::Point> &points, const int target_h);
+
+// a whole line image resized to target_h rows
+cv::Mat GetScaledLineImage(const cv::Mat &line_image, const int target_h);
+
+// indices of text_images by descending width at a common height, the longest lines take the longest
+std::vector<size_t> GetLongestFirstOrder(const std::vector<cv::Mat> &text_images);
 
 void Trim(std::string &s);
 
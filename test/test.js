@@ -1,5 +1,5 @@
 const path = require('path');
-const { PaddleOCR, createOCR } = require('../lib/index');
+const { PaddleOCR, createOCR, expandCompactResults } = require('../lib/index');
 
 // Path to your config and test image
 const CONFIG_PATH = path.join(__dirname, '../models/config.json');
@@ -49,6 +49,35 @@ async function main() {
         console.error('Error detecting text:', err.message);
         process.exit(1);
     }
+
+    // Async detection should match the sync results
+    try {
+        const syncResults = ocr.detect(TEST_IMAGE);
+        const asyncResults = await ocr.detectAsync(TEST_IMAGE);
+        if (asyncResults.length !== syncResults.length) {
+            console.error('Async result count mismatch: ' + asyncResults.length + ' != ' + syncResults.length);
+            process.exit(1);
+        }
+        console.log('Async detection returned ' + asyncResults.length + ' text region(s)');
+    } catch (err) {
+        console.error('Error in async detection:', err.message);
+        process.exit(1);
+    }
+
+    // Compact results should decode to the object results
+    try {
+        const results = ocr.detect(TEST_IMAGE);
+        const compact = ocr.detect(TEST_IMAGE, { compact: true });
+        const expanded = expandCompactResults(compact);
+        if (JSON.stringify(expanded) !== JSON.stringify(results)) {
+            console.error('Compact results do not match the object results');
+            process.exit(1);
+        }
+        console.log('Compact detection returned ' + compact.count + ' text region(s)');
+    } catch (err) {
+        console.error('Error in compact detection:', err.message);
+        process.exit(1);
+    }
 }
 
 main();
@@ -0,0 +1,49 @@
+// Per-box cost of Unclip (closed form for rectangles) against UnclipPolygon
+// (Clipper2 offset + minAreaRect) on random rotated text boxes.
+//
+// Not part of the addon build, compile by hand against the system OpenCV, e.g.
+//   g++ -O2 -std=c++17 -Isrc -Isrc/3rdparty test/unclip_bench.cpp src/utils.cpp
+//       src/3rdparty/clipper2/*.cpp $(pkg-config --cflags --libs opencv4) -lgomp
+// (on macOS take the flags from $(brew --prefix opencv) instead of pkg-config), then
+//   ./a.out [boxes]
+
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+#include "utils.h"
+
+int main(int argc, char **argv)
+{
+    const int num_boxes = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const float unclip_ratio = 1.5f;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(50.0f, 900.0f), width(8.0f, 300.0f), height(8.0f, 60.0f), angle(-90.0f, 90.0f);
+
+    std::vector<std::vector<cv::Point2f>> boxes(num_boxes);
+    for (auto &box : boxes)
+    {
+        int max_side_len = 0;
+        cv::RotatedRect rect(cv::Point2f(pos(rng), pos(rng)), cv::Size2f(width(rng), height(rng)), angle(rng));
+        box = OCR::GetMinBoxes(rect, max_side_len);
+    }
+
+    auto run = [&](const char *name, cv::RotatedRect (*unclip)(const std::vector<cv::Point2f> &, const float))
+    {
+        double sum = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &box : boxes)
+            sum += unclip(box, unclip_ratio).size.area();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-14s %9.1f ns/box  (area sum %.0f)\n", name, elapsed / num_boxes, sum);
+        return elapsed;
+    };
+
+    const double polygon = run("UnclipPolygon", OCR::UnclipPolygon);
+    const double rect = run("Unclip", OCR::Unclip);
+    std::printf("speedup        %9.1fx\n", polygon / rect);
+
+    return 0;
+}